@@ -28,218 +28,58 @@
 
 #include "ButtonEvent.h"
 
-ButtonEventClass::ButtonEventClass()
+ButtonEdgeRing::ButtonEdgeRing()
 {
-	this->count = 0;
-	this->mallocSize = 0;
-	this->initialCapacity = sizeof(ButtonInformation);
+	this->head = 0;
+	this->tail = 0;
+	this->overflows = 0;
 }
 
-void ButtonEventClass::setPosition(short position) { this->currentButton = this->buttons + position; }
+unsigned long ButtonEdgeRing::getOverflows() { return this->overflows; }
 
-void ButtonEventClass::setHoldEvent(short position, ButtonEvent event, unsigned long holdMillisWait)
+void ButtonEdgeRing::attach(Source *source)
 {
-	this->setPosition(position);
-	this->currentButton->holdMillisWait = holdMillisWait;
-	this->currentButton->onHold = event;
+	attachInterruptArg(digitalPinToInterrupt(source->pin), ButtonEdgeRing::onEdge, source, CHANGE);
 }
 
-void ButtonEventClass::setDownEvent(short position, ButtonEvent event)
+void ButtonEdgeRing::detach(Source *source)
 {
-	this->setPosition(position);
-	this->currentButton->onDown = event;
+	detachInterrupt(digitalPinToInterrupt(source->pin));
 }
 
-void ButtonEventClass::setUpEvent(short position, ButtonEvent event)
+void IRAM_ATTR ButtonEdgeRing::onEdge(void *source)
 {
-	this->setPosition(position);
-	this->currentButton->onUp = event;
+	Source *from = (Source *)source;
+	from->ring->push(from);
 }
 
-void ButtonEventClass::setDoubleEvent(short position, ButtonEvent event, unsigned long doubleMillisWait)
+//only the isr moves the head, only loop() moves the tail
+void IRAM_ATTR ButtonEdgeRing::push(Source *source)
 {
-	this->setPosition(position);
-	this->currentButton->doubleMillisWait = doubleMillisWait;
-	this->currentButton->onDouble = event;
-}
-
-void ButtonEventClass::setStumEvent(short position, ButtonEvent event, unsigned long stumMillisWait)
-{
-	this->setPosition(position);
-	this->currentButton->stumMillisWait = stumMillisWait;
-	this->currentButton->onStum = event;
-}
-
-void ButtonEventClass::buttonAgragate()
-{
-	if (this->count > 0)
-	{
-		//determine if the buffer free space fits the next object
-		if (this->mallocSize < (sizeof(ButtonInformation) * (this->count + 1)))
-		{
-			this->mallocSize = sizeof(ButtonInformation) * (this->count + 1);
-			//alocate more memory space
-			this->buttons = (ButtonInformation *)realloc(this->buttons, this->mallocSize);
-		}
-	}
-	else
+	byte head = this->head;
+	byte next = (head + 1) & (BUTTON_RING_SIZE - 1);
+	if (next == this->tail)
 	{
-		//determine if initial capacity parameter fits the first object
-		if (this->initialCapacity >= sizeof(ButtonInformation))
-		{
-			this->mallocSize = this->initialCapacity;
-		}
-		else
-		{
-			this->mallocSize = sizeof(ButtonInformation);
-		}
-		//create the buffer size
-		this->buttons = (ButtonInformation *)malloc(this->mallocSize);
+		this->overflows++;
+		return;
 	}
+	this->edges[head].millis = millis();
+	this->edges[head].index = source->index;
+	this->edges[head].pressed = (digitalRead(source->pin) == HIGH);
+	__asm__ __volatile__("" ::: "memory");
+	this->head = next;
 }
 
-void ButtonEventClass::addButton(short pin)
+bool ButtonEdgeRing::pop(ButtonEdge *edge)
 {
-	this->buttonAgragate();
-
-	this->setPosition(this->count);
-	this->currentButton->pin = pin;
-	this->currentButton->analogValue = NOT_ANALOG;
-	this->currentButton->onDown = NULL;
-	this->currentButton->onUp = NULL;
-	this->currentButton->onHold = NULL;
-	this->currentButton->onDouble = NULL;
-
-	pinMode(this->currentButton->pin, INPUT);
-
-	this->count++;
-}
-
-void ButtonEventClass::addButton(short pin, ButtonEvent onDown, ButtonEvent onUp, ButtonEvent onHold, unsigned long holdMillisWait, ButtonEvent onDouble, unsigned long doubleMillisWait)
-{
-	this->buttonAgragate();
-
-	this->setPosition(this->count);
-	this->currentButton->pin = pin;
-	this->currentButton->analogValue = NOT_ANALOG;
-	this->currentButton->onDown = onDown;
-	this->currentButton->onUp = onUp;
-	this->currentButton->onHold = onHold;
-	this->currentButton->holdMillisWait = holdMillisWait;
-	this->currentButton->onDouble = onDouble;
-	this->currentButton->doubleMillisWait = doubleMillisWait;
-
-	pinMode(this->currentButton->pin, INPUT);
-
-	this->count++;
-}
-
-void ButtonEventClass::addButton(short pin, short analogValue, byte deviation, ButtonEvent onDown, ButtonEvent onUp, ButtonEvent onHold, unsigned long holdMillisWait, ButtonEvent onDouble, unsigned long doubleMillisWait)
-{
-	this->buttonAgragate();
-
-	this->setPosition(this->count);
-	this->currentButton->pin = pin;
-	this->currentButton->analogValue = analogValue;
-	this->currentButton->deviation = deviation;
-	this->currentButton->onDown = onDown;
-	this->currentButton->onUp = onUp;
-	this->currentButton->onHold = onHold;
-	this->currentButton->holdMillisWait = holdMillisWait;
-	this->currentButton->onDouble = onDouble;
-	this->currentButton->doubleMillisWait = doubleMillisWait;
-
-	pinMode(14 + this->currentButton->pin, INPUT);
-	digitalWrite((14 + this->currentButton->pin), HIGH);
-
-	this->count++;
-}
-
-void ButtonEventClass::loop()
-{
-	for (this->index = 0; this->index < this->count; this->index++)
-	{
-		this->setPosition(this->index);
-
-		if (this->currentButton->analogValue == NOT_ANALOG)
-		{
-			this->nextPressed = (digitalRead(this->currentButton->pin) == HIGH);
-		}
-		else
-		{
-			this->nextAnalogRead = analogRead(this->currentButton->pin);
-			this->nextPressed = ((this->nextAnalogRead >= (this->currentButton->analogValue - this->currentButton->deviation)) && (this->nextAnalogRead <= (this->currentButton->analogValue + this->currentButton->deviation)));
-		}
-
-		//down event
-		if (this->nextPressed)
-		{
-			if (this->currentButton->pressed)
-			{
-				//hold event
-				if (!this->currentButton->hold && this->currentButton->onHold != NULL && this->currentButton->holdMillisWait > 0)
-				{
-					this->currentButton->holdMillis = millis() - this->currentButton->startMillis; //calculate time
-					bool holded = this->currentButton->holdMillis >= this->currentButton->holdMillisWait;
-					if (holded)
-					{
-						this->currentButton->onHold(this->currentButton); //call event
-						this->currentButton->hold = true;
-					}
-				}
-			}
-			else
-			{
-				//double event
-				if (this->currentButton->onDouble != NULL && this->currentButton->doubleMillisWait > 0)
-				{
-					this->lastMillis = millis();
-					this->currentButton->doubleMillis = this->lastMillis - this->currentButton->startMillis; //calculate time
-					this->currentButton->startMillis = this->lastMillis;
-					bool doubled = this->currentButton->doubleMillis <= this->currentButton->doubleMillisWait;
-					if (doubled)
-						this->currentButton->onDouble(this->currentButton); //call event
-					else if (this->currentButton->onDown != NULL)
-						//down event
-						this->currentButton->onDown(this->currentButton); //call event
-				}
-				else
-				{
-					//down event
-					this->currentButton->startMillis = millis();
-					if (this->currentButton->onDown != NULL)
-						this->currentButton->onDown(this->currentButton); //call event
-				}
-			}
-			this->currentButton->stumMillis = millis(); //calculate time
-			this->currentButton->stuned = false;
-		}
-		else
-		{
-			// stum event
-			if (this->currentButton->onStum != NULL && !this->currentButton->stuned)
-			{
-				bool stuned = (millis() - this->currentButton->stumMillis) > this->currentButton->stumMillisWait;
-				if (stuned)
-				{
-					this->currentButton->onStum(this->currentButton); //call event
-					this->currentButton->stuned = true;
-				}
-			}
-		}
-
-		//up event
-		if (!this->nextPressed && this->currentButton->pressed)
-		{
-			if (this->currentButton->onUp != NULL)
-			{
-				this->currentButton->holdMillis = millis() - this->currentButton->startMillis; //calculate time
-				this->currentButton->onUp(this->currentButton);								   //call event
-			}
-			this->currentButton->hold = false;
-		}
-		this->currentButton->pressed = this->nextPressed;
-	}
+	byte tail = this->tail;
+	if (tail == this->head)
+		return false;
+	__asm__ __volatile__("" ::: "memory");
+	*edge = this->edges[tail];
+	__asm__ __volatile__("" ::: "memory");
+	this->tail = (tail + 1) & (BUTTON_RING_SIZE - 1);
+	return true;
 }
 
-ButtonEventClass ButtonEvent;
\ No newline at end of file
+ButtonEventClass ButtonEvent;
@@ -38,60 +38,452 @@
 #endif
 
 #define NOT_ANALOG -99
+#define BUTTON_RING_SIZE 16     //edges buffered between loops, power of two
+#define BUTTON_EVENT_CAPACITY 4 //buttons of the global ButtonEvent instance
+#define LADDER_SCAN_MILLIS 20   //analog ladder scan period
+#define LADDER_SAMPLES 4        //adc conversions averaged per scan
+#define LADDER_DEBOUNCE 2       //equal scans needed to accept a key
 
+typedef byte ButtonHandle;
+#define INVALID_BUTTON 0xFF
+
+//snapshot of the button handed to the event callbacks
 struct ButtonInformation
 {
+  ButtonHandle handle;
   short pin;
+  unsigned long holdMillis;
+  unsigned long doubleMillis;
+};
+
+typedef void (*ButtonCallback)(ButtonInformation *sender);
+
+//cold, per button configuration: only read when an event fires
+struct ButtonConfig
+{
   short analogValue;
   byte deviation;
-  bool pressed;
-  bool hold;
-  bool stuned;
-  unsigned long startMillis;
-  unsigned long holdMillis;
   unsigned long holdMillisWait;
-  unsigned long doubleMillis;
   unsigned long doubleMillisWait;
-  unsigned long stumMillis;
   unsigned long stumMillisWait;
-  void (*onDown)(ButtonInformation *Sender);
-  void (*onUp)(ButtonInformation *Sender);
-  void (*onHold)(ButtonInformation *Sender);
-  void (*onDouble)(ButtonInformation *Sender);
-  void (*onStum)(ButtonInformation *Sender);
+  ButtonCallback onDown;
+  ButtonCallback onUp;
+  ButtonCallback onHold;
+  ButtonCallback onDouble;
+  ButtonCallback onStum;
+};
+
+struct ButtonEdge
+{
+  unsigned long millis;
+  byte index;
+  bool pressed;
+};
+
+typedef void (*ButtonEdgeCallback)(const ButtonEdge *edge);
+
+//single producer (isr) / single consumer (loop) ring of timestamped edges
+class ButtonEdgeRing
+{
+public:
+  struct Source
+  {
+    ButtonEdgeRing *ring;
+    byte index;
+    short pin;
+  };
+
+  ButtonEdgeRing();
+  void attach(Source *source);
+  void detach(Source *source);
+  bool pop(ButtonEdge *edge);
+  unsigned long getOverflows();
+
+private:
+  volatile byte head;
+  volatile byte tail;
+  volatile unsigned long overflows;
+  ButtonEdge edges[BUTTON_RING_SIZE];
+  void push(Source *source);
+  static void onEdge(void *source);
 };
 
-class ButtonEventClass
+//fixed capacity button scanner: no heap, footprint known at link time.
+//the per loop scan state is kept in parallel arrays, apart from the
+//configuration that is only touched when an event fires.
+template <byte N>
+class ButtonEvents
 {
 public:
-  typedef void (*ButtonEvent)(ButtonInformation *sender);
+  typedef ButtonCallback ButtonEvent;
 
-  ButtonEventClass();
-  short initialCapacity;
-  void addButton(short pin);
-  void addButton(short pin, ButtonEvent onDown, ButtonEvent onUp, ButtonEvent onHold, unsigned long holdMillisWait, ButtonEvent onDouble, unsigned long doubleMillisWait);
-  void addButton(short pin, short analogValue, byte deviation, ButtonEvent onDown, ButtonEvent onUp, ButtonEvent onHold, unsigned long holdMillisWait, ButtonEvent onDouble, unsigned long doubleMillisWait);
+  ButtonEvents();
+  ButtonHandle addButton(short pin);
+  ButtonHandle addButton(short pin, ButtonEvent onDown, ButtonEvent onUp, ButtonEvent onHold, unsigned long holdMillisWait, ButtonEvent onDouble, unsigned long doubleMillisWait);
+  ButtonHandle addButton(short pin, short analogValue, byte deviation, ButtonEvent onDown, ButtonEvent onUp, ButtonEvent onHold, unsigned long holdMillisWait, ButtonEvent onDouble, unsigned long doubleMillisWait);
   void loop();
-  void setHoldEvent(short position, ButtonEvent event, unsigned long holdMillisWait = 1000);
-  void setDownEvent(short position, ButtonEvent event);
-  void setUpEvent(short position, ButtonEvent event);
-  void setDoubleEvent(short position, ButtonEvent event, unsigned long doubleMillisWait = 500);
-  void setStumEvent(short position, ButtonEvent event, unsigned long stumMillisWait = 3000);
+  void setHoldEvent(ButtonHandle button, ButtonEvent event, unsigned long holdMillisWait = 1000);
+  void setDownEvent(ButtonHandle button, ButtonEvent event);
+  void setUpEvent(ButtonHandle button, ButtonEvent event);
+  void setDoubleEvent(ButtonHandle button, ButtonEvent event, unsigned long doubleMillisWait = 500);
+  void setStumEvent(ButtonHandle button, ButtonEvent event, unsigned long stumMillisWait = 3000);
+  void setInterruptMode(bool enable);
+  void setEdgeEvent(ButtonEdgeCallback event);
+  void setAnalogScan(unsigned long scanMillis, byte samples = LADDER_SAMPLES, byte debounce = LADDER_DEBOUNCE);
+  unsigned long getOverflows();
 
 private:
-  bool nextPressed;
-  short nextAnalogRead;
-  short count;
-  short mallocSize;
-  short index;
-  unsigned long lastMillis;
-  ButtonInformation *buttons;
-  ButtonInformation *currentButton;
-  void setPosition(short Position);
-  void buttonAgragate();
+  enum Flags : byte
+  {
+    PRESSED = 1,
+    HOLD = 2,
+    STUNED = 4,
+    ANALOG = 8
+  };
+
+  byte count;
+  bool interruptMode;
+  ButtonEdgeCallback edgeEvent;
+  //hot scan state
+  short pins[N];
+  byte flags[N];
+  unsigned long startMillis[N];
+  unsigned long stumMillis[N];
+  //cold configuration
+  ButtonConfig config[N];
+  ButtonEdgeRing ring;
+  ButtonEdgeRing::Source sources[N];
+  unsigned long seenOverflows;
+  //analog buttons share one ladder on one adc pin, sorted by analogValue
+  ButtonHandle ladder[N];
+  byte ladderCount;
+  short ladderPin;
+  ButtonHandle ladderKey;
+  ButtonHandle ladderCandidate;
+  byte ladderStable;
+  byte ladderSamples;
+  byte ladderDebounce;
+  unsigned long ladderScanMillis;
+  unsigned long ladderScanned;
+
+  ButtonHandle add(short pin, short analogValue, byte deviation);
+  void scanLadder(unsigned long now);
+  ButtonHandle classify(short value);
+  void update(ButtonHandle button, bool nextPressed, unsigned long now);
+  void fire(ButtonEvent event, ButtonHandle button, unsigned long holdMillis, unsigned long doubleMillis);
 };
 
+template <byte N>
+ButtonEvents<N>::ButtonEvents()
+{
+	this->count = 0;
+	this->interruptMode = false;
+	this->edgeEvent = NULL;
+	this->seenOverflows = 0;
+	this->ladderCount = 0;
+	this->ladderKey = INVALID_BUTTON;
+	this->ladderCandidate = INVALID_BUTTON;
+	this->ladderStable = 0;
+	this->ladderScanned = 0;
+	this->setAnalogScan(LADDER_SCAN_MILLIS);
+}
+
+template <byte N>
+ButtonHandle ButtonEvents<N>::add(short pin, short analogValue, byte deviation)
+{
+	if (this->count >= N)
+		return INVALID_BUTTON;
+
+	ButtonHandle button = this->count++;
+	this->pins[button] = pin;
+	this->flags[button] = analogValue == NOT_ANALOG ? 0 : ANALOG;
+	this->startMillis[button] = 0;
+	this->stumMillis[button] = millis();
+	this->config[button] = {analogValue, deviation, 0, 0, 0, NULL, NULL, NULL, NULL, NULL};
+	this->sources[button] = {&this->ring, button, pin};
+
+	if (analogValue == NOT_ANALOG)
+	{
+		pinMode(pin, INPUT);
+		if (digitalRead(pin) == HIGH)
+			this->flags[button] |= PRESSED;
+		if (this->interruptMode)
+			this->ring.attach(this->sources + button);
+	}
+	else
+	{
+		pinMode(14 + pin, INPUT);
+		digitalWrite((14 + pin), HIGH);
+
+		//insertion keeps the ladder sorted for classify()
+		byte i = this->ladderCount++;
+		for (; i > 0 && this->config[this->ladder[i - 1]].analogValue > analogValue; i--)
+			this->ladder[i] = this->ladder[i - 1];
+		this->ladder[i] = button;
+		this->ladderPin = pin;
+	}
+	return button;
+}
+
+template <byte N>
+ButtonHandle ButtonEvents<N>::addButton(short pin)
+{
+	return this->add(pin, NOT_ANALOG, 0);
+}
+
+template <byte N>
+ButtonHandle ButtonEvents<N>::addButton(short pin, ButtonEvent onDown, ButtonEvent onUp, ButtonEvent onHold, unsigned long holdMillisWait, ButtonEvent onDouble, unsigned long doubleMillisWait)
+{
+	return this->addButton(pin, NOT_ANALOG, 0, onDown, onUp, onHold, holdMillisWait, onDouble, doubleMillisWait);
+}
+
+template <byte N>
+ButtonHandle ButtonEvents<N>::addButton(short pin, short analogValue, byte deviation, ButtonEvent onDown, ButtonEvent onUp, ButtonEvent onHold, unsigned long holdMillisWait, ButtonEvent onDouble, unsigned long doubleMillisWait)
+{
+	ButtonHandle button = this->add(pin, analogValue, deviation);
+	if (button == INVALID_BUTTON)
+		return button;
+	ButtonConfig *config = this->config + button;
+	config->onDown = onDown;
+	config->onUp = onUp;
+	config->onHold = onHold;
+	config->holdMillisWait = holdMillisWait;
+	config->onDouble = onDouble;
+	config->doubleMillisWait = doubleMillisWait;
+	return button;
+}
+
+template <byte N>
+void ButtonEvents<N>::setHoldEvent(ButtonHandle button, ButtonEvent event, unsigned long holdMillisWait)
+{
+	if (button >= this->count)
+		return;
+	this->config[button].holdMillisWait = holdMillisWait;
+	this->config[button].onHold = event;
+}
+
+template <byte N>
+void ButtonEvents<N>::setDownEvent(ButtonHandle button, ButtonEvent event)
+{
+	if (button < this->count)
+		this->config[button].onDown = event;
+}
+
+template <byte N>
+void ButtonEvents<N>::setUpEvent(ButtonHandle button, ButtonEvent event)
+{
+	if (button < this->count)
+		this->config[button].onUp = event;
+}
+
+template <byte N>
+void ButtonEvents<N>::setDoubleEvent(ButtonHandle button, ButtonEvent event, unsigned long doubleMillisWait)
+{
+	if (button >= this->count)
+		return;
+	this->config[button].doubleMillisWait = doubleMillisWait;
+	this->config[button].onDouble = event;
+}
+
+template <byte N>
+void ButtonEvents<N>::setStumEvent(ButtonHandle button, ButtonEvent event, unsigned long stumMillisWait)
+{
+	if (button >= this->count)
+		return;
+	this->config[button].stumMillisWait = stumMillisWait;
+	this->config[button].onStum = event;
+}
+
+template <byte N>
+unsigned long ButtonEvents<N>::getOverflows() { return this->ring.getOverflows(); }
+
+template <byte N>
+void ButtonEvents<N>::setInterruptMode(bool enable)
+{
+	for (ButtonHandle button = 0; button < this->count; button++)
+	{
+		if (this->flags[button] & ANALOG)
+			continue;
+		if (enable)
+			this->ring.attach(this->sources + button);
+		else
+			this->ring.detach(this->sources + button);
+	}
+	this->interruptMode = enable;
+}
+
+//called on every press and release, whatever the source, before the events
+template <byte N>
+void ButtonEvents<N>::setEdgeEvent(ButtonEdgeCallback event)
+{
+	this->edgeEvent = event;
+}
+
+template <byte N>
+void ButtonEvents<N>::setAnalogScan(unsigned long scanMillis, byte samples, byte debounce)
+{
+	this->ladderScanMillis = scanMillis;
+	this->ladderSamples = samples > 0 ? samples : 1;
+	this->ladderDebounce = debounce > 0 ? debounce : 1;
+}
+
+//one oversampled conversion per scan period serves every analog button
+template <byte N>
+void ButtonEvents<N>::scanLadder(unsigned long now)
+{
+	if (this->ladderCount == 0 || now - this->ladderScanned < this->ladderScanMillis)
+		return;
+	this->ladderScanned = now;
+
+	long sum = 0;
+	for (byte i = 0; i < this->ladderSamples; i++)
+		sum += analogRead(this->ladderPin);
+	ButtonHandle key = this->classify(sum / this->ladderSamples);
+
+	if (key != this->ladderCandidate)
+	{
+		this->ladderCandidate = key;
+		this->ladderStable = 0;
+	}
+	if (this->ladderStable < this->ladderDebounce && ++this->ladderStable == this->ladderDebounce)
+		this->ladderKey = key;
+}
+
+//binary search for the first window whose upper bound reaches the value
+template <byte N>
+ButtonHandle ButtonEvents<N>::classify(short value)
+{
+	byte low = 0, high = this->ladderCount;
+	while (low < high)
+	{
+		byte middle = (low + high) / 2;
+		const ButtonConfig *config = this->config + this->ladder[middle];
+		if (config->analogValue + config->deviation < value)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	if (low == this->ladderCount)
+		return INVALID_BUTTON;
+	const ButtonConfig *config = this->config + this->ladder[low];
+	return value >= config->analogValue - config->deviation ? this->ladder[low] : INVALID_BUTTON;
+}
+
+template <byte N>
+void ButtonEvents<N>::loop()
+{
+	//replay the edges captured by the isr at the time they happened
+	ButtonEdge edge;
+	while (this->ring.pop(&edge))
+		this->update(edge.index, edge.pressed, edge.millis);
+	//a full ring drops the newest edges, usually the one a bounce settles on:
+	//after an overflow the lines themselves say where the buttons are
+	unsigned long overflows = this->ring.getOverflows();
+	bool resync = overflows != this->seenOverflows;
+	this->seenOverflows = overflows;
+
+	unsigned long now = millis();
+	this->scanLadder(now);
+	for (ButtonHandle button = 0; button < this->count; button++)
+	{
+		//with interrupts only the hold and stum timers are left to check
+		bool nextPressed;
+		if (this->flags[button] & ANALOG)
+			nextPressed = this->ladderKey == button;
+		else if (this->interruptMode && !resync)
+			nextPressed = this->flags[button] & PRESSED;
+		else
+			nextPressed = digitalRead(this->pins[button]) == HIGH;
+		this->update(button, nextPressed, now);
+	}
+}
+
+template <byte N>
+void ButtonEvents<N>::fire(ButtonEvent event, ButtonHandle button, unsigned long holdMillis, unsigned long doubleMillis)
+{
+	ButtonInformation sender = {button, this->pins[button], holdMillis, doubleMillis};
+	event(&sender);
+}
+
+template <byte N>
+void ButtonEvents<N>::update(ButtonHandle button, bool nextPressed, unsigned long now)
+{
+	byte state = this->flags[button];
+	const ButtonConfig *config = this->config + button;
+
+	if (this->edgeEvent != NULL && nextPressed != ((state & PRESSED) != 0))
+	{
+		ButtonEdge edge = {now, button, nextPressed};
+		this->edgeEvent(&edge);
+	}
+
+	//down event
+	if (nextPressed)
+	{
+		if (state & PRESSED)
+		{
+			//hold event
+			if (!(state & HOLD) && config->onHold != NULL && config->holdMillisWait > 0)
+			{
+				unsigned long holdMillis = now - this->startMillis[button]; //calculate time
+				if (holdMillis >= config->holdMillisWait)
+				{
+					this->fire(config->onHold, button, holdMillis, 0); //call event
+					state |= HOLD;
+				}
+			}
+		}
+		else
+		{
+			//double event
+			if (config->onDouble != NULL && config->doubleMillisWait > 0)
+			{
+				unsigned long doubleMillis = now - this->startMillis[button]; //calculate time
+				this->startMillis[button] = now;
+				if (doubleMillis <= config->doubleMillisWait)
+					this->fire(config->onDouble, button, 0, doubleMillis); //call event
+				else if (config->onDown != NULL)
+					//down event
+					this->fire(config->onDown, button, 0, doubleMillis); //call event
+			}
+			else
+			{
+				//down event
+				this->startMillis[button] = now;
+				if (config->onDown != NULL)
+					this->fire(config->onDown, button, 0, 0); //call event
+			}
+		}
+		this->stumMillis[button] = now;
+		state &= ~STUNED;
+	}
+	else
+	{
+		// stum event
+		if (config->onStum != NULL && !(state & STUNED) && (now - this->stumMillis[button]) > config->stumMillisWait)
+		{
+			this->fire(config->onStum, button, 0, 0); //call event
+			state |= STUNED;
+		}
+	}
+
+	//up event
+	if (!nextPressed && (state & PRESSED))
+	{
+		if (config->onUp != NULL)
+			this->fire(config->onUp, button, now - this->startMillis[button], 0); //call event
+		state &= ~HOLD;
+	}
+	if (nextPressed)
+		state |= PRESSED;
+	else
+		state &= ~PRESSED;
+	this->flags[button] = state;
+}
+
+typedef ButtonEvents<BUTTON_EVENT_CAPACITY> ButtonEventClass;
+
 //global instance
 extern ButtonEventClass ButtonEvent;
 
-#endif
\ No newline at end of file
+#endif
@@ -1,41 +1,43 @@
 #include "Thermostat.h"
 
-Thermostat::Thermostat(uint8_t pinFan, uint8_t pinCool, uint8_t pinHeat) {
-  _pinFan = pinFan;
-  _pinCool = pinCool;
-  _pinHeat = pinHeat;
+ThermostatEngine::ThermostatEngine(uint8_t pinFan, uint8_t pinCool, uint8_t pinHeat) : _relays(pinFan, pinCool, pinHeat) {
   _state = ThermostatState::OFF;
 }
 
-void Thermostat::begin(){
-  pinMode(_pinHeat, OUTPUT);
-  digitalWrite(_pinHeat, HIGH);
-  pinMode(_pinCool, OUTPUT);
-  digitalWrite(_pinCool, HIGH);
-  pinMode(_pinFan, OUTPUT);
-  digitalWrite(_pinFan, HIGH);
-}
+void ThermostatEngine::begin(){ _relays.begin(); }
+
+void ThermostatEngine::setHysteresis(float band){ _timing.hysteresis = band; }
+void ThermostatEngine::setMinOnTime(unsigned long ms){ _timing.minOnTime = ms; }
+void ThermostatEngine::setMinOffTime(unsigned long ms){ _timing.minOffTime = ms; }
+void ThermostatEngine::setFanOverrun(unsigned long ms){ _timing.fanOverrun = ms; }
+void ThermostatEngine::setPointDeadband(float band){ _pointDeadband = band; }
+void ThermostatEngine::setTemperatureDeadband(float band){ _temperatureDeadband = band; }
+
+ThermostatState ThermostatEngine::getState(){ return _state; }
+bool ThermostatEngine::isHeat(){ return _state == ThermostatState::HEAT; }
+bool ThermostatEngine::isCool(){ return _state == ThermostatState::COOL; }
+bool ThermostatEngine::isFan(){ return _state == ThermostatState::FAN; }
+bool ThermostatEngine::isOff(){ return _state == ThermostatState::OFF; }
+ThermostatRelays* ThermostatEngine::getRelays(){ return &_relays; }
+bool ThermostatEngine::isStandby(){ return (isHeat() || isCool()) && _cycle.phase != ThermostatCycle::RUNNING; }
+uint32_t ThermostatEngine::getCycles(){ return _cycle.cycles; }
+uint32_t ThermostatEngine::getTransitions(){ return _transitions; }
 
-void Thermostat::setState(String state){ setState(strToState(state)); }
-void Thermostat::setOnStateChange(std::function<ThermostatState(ThermostatState, ThermostatState)> func){ _onStateChange = func; }
-void Thermostat::setOnPointChange(std::function<float(float, float)> func){ _onPointChange = func; }
-void Thermostat::setOnTemperatureChange(std::function<float(float, float)> func){ _onTemperatureChange = func; }
+float ThermostatEngine::getCyclesPerHour(unsigned long now){
+  unsigned long elapsed = now - _firstRun;
+  return elapsed > 0 ? _cycle.cycles * 3600000.0 / elapsed : 0;
+}
 
-ThermostatState Thermostat::getState(){ return _state; }
-bool Thermostat::isHeat(){ return _state == ThermostatState::HEAT; }
-bool Thermostat::isCool(){ return _state == ThermostatState::COOL; }
-bool Thermostat::isFan(){ return _state == ThermostatState::FAN; }
-bool Thermostat::isOff(){ return _state == ThermostatState::OFF; }
-bool Thermostat::isStandby(){ return (isHeat() && _point <= _temperature) || (isCool() && _point >= _temperature); }
+ThermostatState ThermostatEngine::strToState(String state){ return strToState(state.c_str()); }
 
-ThermostatState Thermostat::strToState(String state){
-  if(state == "heat"){ return HEAT; }
-  else if(state == "cool"){ return COOL; }
-  else if(state == "fan"){ return FAN; }
+ThermostatState ThermostatEngine::strToState(const char *state){
+  if(strcmp(state, "heat") == 0){ return HEAT; }
+  else if(strcmp(state, "cool") == 0){ return COOL; }
+  else if(strcmp(state, "fan") == 0){ return FAN; }
   else return OFF;
 }
 
-String Thermostat::stateToStr(ThermostatState state){
+const char *ThermostatEngine::stateToStr(ThermostatState state){
   switch(state){
     case HEAT: return "heat";
     case COOL: return "cool";
@@ -44,48 +46,51 @@ String Thermostat::stateToStr(ThermostatState state){
   }
 }
 
-void Thermostat::setState(ThermostatState state){
-  if(_state == state) return;
-  ThermostatState nextState = state;
-  if ( _onStateChange != NULL) nextState = _onStateChange(_state, state); 
-  _state = nextState;
+// Exact changes always count (to or from NaN included); otherwise the
+// change has to reach the deadband before the hooks hear about it.
+bool ThermostatEngine::isChange(float current, float next, float deadband){
+  if(current == next || (isnan(current) && isnan(next))) return false;
+  return !(fabs(next - current) < deadband);
 }
 
-void Thermostat::setPoint(float point){
-  if(_point == point) return;
-  float nextPoint = point;
-  if ( _onPointChange != NULL)  nextPoint = _onPointChange(_point, point); 
-  _point = nextPoint;
-}
+// Timed cycle state machine: a cycle lasts at least the minimum on time,
+// the compressor rests at least the minimum off time between cycles and
+// the fan keeps running for the overrun time after a cycle. Switching off
+// or changing mode ends a cycle at once. Returns the relay outputs.
+uint8_t ThermostatEngine::step(ThermostatCycle &cycle, ThermostatState state, bool demand, unsigned long now, const ThermostatTiming &timing){
+  if (cycle.phase == ThermostatCycle::RUNNING) {
+    if (state != cycle.running) {
+      cycle.phase = ThermostatCycle::IDLE;
+      cycle.stoppedAt = now;
+    } else if (!demand && now - cycle.startedAt >= timing.minOnTime) {
+      cycle.phase = timing.fanOverrun > 0 ? ThermostatCycle::OVERRUN : ThermostatCycle::IDLE;
+      cycle.stoppedAt = now;
+    }
+  } else if (cycle.phase == ThermostatCycle::OVERRUN && (state == OFF || now - cycle.stoppedAt >= timing.fanOverrun)) {
+    cycle.phase = ThermostatCycle::IDLE;
+  }
 
-void Thermostat::setTemperature(float temperature){
-  if(_temperature == temperature) return;
-  float nextTemperature = temperature;
-  if ( _onTemperatureChange != NULL) nextTemperature = _onTemperatureChange(_temperature, temperature); 
-  _temperature = nextTemperature;
-}
+  if (cycle.phase != ThermostatCycle::RUNNING && demand && (!cycle.hasRun || now - cycle.stoppedAt >= timing.minOffTime)) {
+    cycle.phase = ThermostatCycle::RUNNING;
+    cycle.running = state;
+    cycle.startedAt = now;
+    cycle.hasRun = true;
+    cycle.cycles++;
+  }
 
-void Thermostat::runner(ThermostatState state, float point, float temperature){
+  if (cycle.phase == ThermostatCycle::RUNNING) return RELAY_FAN | (state == COOL ? RELAY_COOL : RELAY_HEAT);
+  if (cycle.phase == ThermostatCycle::OVERRUN || state == FAN) return RELAY_FAN;
+  return 0;
+}
 
-  setPoint(point);
-  setTemperature(temperature);
-  setState(state);
-    
-  if (isOff() || isStandby()) {
-    digitalWrite(_pinHeat, HIGH);
-    digitalWrite(_pinCool, HIGH);
-    digitalWrite(_pinFan, HIGH);
-  } else {
-    digitalWrite(_pinFan, LOW);
-    if(isCool()){
-      digitalWrite(_pinHeat, HIGH);
-      digitalWrite(_pinCool, LOW);
-    } else if (isHeat()) {
-      digitalWrite(_pinHeat, LOW);
-      digitalWrite(_pinCool, HIGH);
-    } else {
-      digitalWrite(_pinHeat, HIGH);
-      digitalWrite(_pinCool, HIGH);
-    }
+void ThermostatEngine::control(unsigned long now){
+  if (!_clocked) {
+    _firstRun = now;
+    _clocked = true;
   }
+  bool running = _cycle.phase == ThermostatCycle::RUNNING;
+  uint8_t outputs = step(_cycle, _state, demand(_state, running, _point, _temperature, _timing.hysteresis), now, _timing);
+  if (outputs != _outputs) _transitions++;
+  _outputs = outputs;
+  _relays.write(outputs);
 }
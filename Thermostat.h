@@ -2,22 +2,42 @@
 #define Thermostat_H
 
 #include "Arduino.h"
+#include "ThermostatRelays.h"
 
 
 enum ThermostatState { OFF, HEAT, COOL, FAN };
 
-class Thermostat {
+// Settings of the compressor cycle, shared by all zones of a controller.
+struct ThermostatTiming {
+  float hysteresis = 0;
+  unsigned long minOnTime = 0, minOffTime = 0, fanOverrun = 0;
+};
+
+// Compressor cycle of one zone: IDLE -> RUNNING -> OVERRUN (fan only) -> IDLE
+struct ThermostatCycle {
+  enum Phase : uint8_t { IDLE, RUNNING, OVERRUN };
+  Phase phase = IDLE;
+  ThermostatState running = OFF;
+  bool hasRun = false;
+  unsigned long startedAt = 0, stoppedAt = 0;
+  uint32_t cycles = 0;
+};
+
+// Control engine shared by every hook flavor: state, relays and the
+// compressor cycle state machine. Change notification lives in the hooks.
+// demand() and step() are the state machine itself, also run per zone by
+// ThermostatGroup.
+class ThermostatEngine {
   public:    
-    Thermostat(uint8_t pinFan=0,uint8_t pinCool=1,uint8_t pinHeat=2);
+    ThermostatEngine(uint8_t pinFan, uint8_t pinCool, uint8_t pinHeat);
     void begin();
     
-    void setState(String state);
-    void setState(ThermostatState state);
-    void setPoint(float point);
-    void setTemperature(float temperature);
-    void setOnStateChange(std::function<ThermostatState(ThermostatState, ThermostatState)> func);
-    void setOnPointChange(std::function<float(float, float)> func);
-    void setOnTemperatureChange(std::function<float(float, float)> func);
+    void setHysteresis(float band);
+    void setMinOnTime(unsigned long ms);
+    void setMinOffTime(unsigned long ms);
+    void setFanOverrun(unsigned long ms);
+    void setPointDeadband(float band);
+    void setTemperatureDeadband(float band);
     
     ThermostatState getState();
     bool isHeat();
@@ -25,19 +45,107 @@ class Thermostat {
     bool isOff();
     bool isFan();
     bool isStandby();
+    ThermostatRelays* getRelays();
+    uint32_t getCycles();
+    uint32_t getTransitions();
+    float getCyclesPerHour(unsigned long now);
     
-    void runner(ThermostatState state, float point, float temperature);
     static ThermostatState strToState(String state);
-    static String stateToStr(ThermostatState state);
+    static ThermostatState strToState(const char *state);
+    static const char *stateToStr(ThermostatState state);
     
-  private:
-    uint8_t _pinFan, _pinCool, _pinHeat, _ledOff, _ledStby;
-    bool _isStandby = false;
+    // Demand with a hysteresis band centered on the point: a running cycle
+    // keeps going until the far edge of the band. NaN compares false, so
+    // no reading means no demand. Branch-free, for batches of zones.
+    static inline bool demand(ThermostatState state, bool running, float point, float temperature, float hysteresis){
+      float offset = running ? -hysteresis / 2 : hysteresis / 2;
+      return (state == COOL && temperature > point + offset) | (state == HEAT && temperature < point - offset);
+    }
+    static uint8_t step(ThermostatCycle &cycle, ThermostatState state, bool demand, unsigned long now, const ThermostatTiming &timing);
+    static bool isChange(float current, float next, float deadband = 0);
+    
+  protected:
     ThermostatState _state;
-    float _point, _temperature;
+    float _point = NAN, _reportedPoint = NAN, _temperature = NAN, _reportedTemperature = NAN;
+    float _pointDeadband = 0, _temperatureDeadband = 0;
+    void control(unsigned long now);
+
+  private:
+    ThermostatRelays _relays;
+    uint8_t _ledOff, _ledStby;
+    bool _isStandby = false, _clocked = false;
+    ThermostatTiming _timing;
+    ThermostatCycle _cycle;
+    unsigned long _firstRun = 0;
+    uint32_t _transitions = 0;
+    uint8_t _outputs = 0;
+};
+
+// Hooks bound at run time, through std::function.
+class ThermostatFunctionHooks {
+  public:
+    void setOnStateChange(std::function<ThermostatState(ThermostatState, ThermostatState)> func){ _onStateChange = func; }
+    void setOnPointChange(std::function<float(float, float)> func){ _onPointChange = func; }
+    void setOnTemperatureChange(std::function<float(float, float)> func){ _onTemperatureChange = func; }
+
+  protected:
+    ThermostatState onStateChange(ThermostatState oldState, ThermostatState state){ return _onStateChange != NULL ? _onStateChange(oldState, state) : state; }
+    float onPointChange(float oldPoint, float point){ return _onPointChange != NULL ? _onPointChange(oldPoint, point) : point; }
+    float onTemperatureChange(float oldTemperature, float temperature){ return _onTemperatureChange != NULL ? _onTemperatureChange(oldTemperature, temperature) : temperature; }
+
+  private:
     std::function<ThermostatState(ThermostatState, ThermostatState)> _onStateChange;
     std::function<float(float, float)> _onPointChange;
     std::function<float(float, float)> _onTemperatureChange;
 };
 
+// Hooks that accept every change; derive from it and hide the handlers
+// you need to bind them at compile time.
+struct ThermostatNoHooks {
+  ThermostatState onStateChange(ThermostatState oldState, ThermostatState state){ return state; }
+  float onPointChange(float oldPoint, float point){ return point; }
+  float onTemperatureChange(float oldTemperature, float temperature){ return temperature; }
+};
+
+// Thermostat whose change handlers come from the Hooks policy; with
+// compile-time hooks runner() has no indirect call left to make.
+template <class Hooks>
+class BasicThermostat : public ThermostatEngine, public Hooks {
+  public:
+    BasicThermostat(uint8_t pinFan=0,uint8_t pinCool=1,uint8_t pinHeat=2) : ThermostatEngine(pinFan, pinCool, pinHeat) {}
+    
+    void setState(String state){ setState(strToState(state)); }
+    
+    void setState(ThermostatState state){
+      if(_state == state) return;
+      _state = Hooks::onStateChange(_state, state);
+    }
+    
+    // control always runs on the value given; the deadband only holds
+    // back the notification until it moved far enough from the last one
+    // reported
+    void setPoint(float point){
+      _point = point;
+      if(!isChange(_reportedPoint, point, _pointDeadband)) return;
+      _reportedPoint = Hooks::onPointChange(_reportedPoint, point);
+    }
+    
+    void setTemperature(float temperature){
+      _temperature = temperature;
+      if(!isChange(_reportedTemperature, temperature, _temperatureDeadband)) return;
+      _reportedTemperature = Hooks::onTemperatureChange(_reportedTemperature, temperature);
+    }
+    
+    void runner(ThermostatState state, float point, float temperature){ runner(state, point, temperature, millis()); }
+    
+    void runner(ThermostatState state, float point, float temperature, unsigned long now){
+      setPoint(point);
+      setTemperature(temperature);
+      setState(state);
+      control(now);
+    }
+};
+
+typedef BasicThermostat<ThermostatFunctionHooks> Thermostat;
+
 #endif
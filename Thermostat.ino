@@ -1,21 +1,57 @@
 #include <DNSServer.h>
 #include <ESP8266WebServer.h>
 #include <WiFiManager.h>
-#include "DHT.h"
 #include <EEPROM.h>
 #include <WebSocketsClient.h>
-#include <ArduinoJson.h>
-#include <StreamString.h>
 #include "Thermostat.h"
 #include "ThermostatIRCtrls.h"
 #include "ThermostatDisplay.h"
+#include "ThermostatDHT.h"
+#include "ThermostatSensor.h"
+#include "ThermostatScheduler.h"
+#include "ThermostatJournal.h"
+#include "ThermostatTelemetry.h"
+#include "ThermostatCommand.h"
+#include "ThermostatOutbox.h"
+#include "ThermostatSimulation.h"
+#include "ThermostatProfiler.h"
+#include "ThermostatTrace.h"
+#include "ThermostatNetwork.h"
 #include "ButtonEvent.h"
 
+// each flag can be overridden from the build (-DTRACE=1 -DDEBUG=0)
+#ifndef DEBUG
 #define DEBUG true
+#endif
+#ifndef SIMULATE
+#define SIMULATE false    // drive the control loop from a room model
+#endif
+#ifndef SIMULATE_SPEED
+#define SIMULATE_SPEED 60 // simulated ms per real ms
+#endif
+#define PROFILE THERMOSTAT_PROFILE // cycle-count profile of every scheduler task, set in build_opt.h
+#ifndef TRACE
+#define TRACE false       // binary trace of the loop inputs on Serial, with DEBUG off
+#endif
+#if TRACE && DEBUG
+#error "TRACE writes binary records to Serial, build it with DEBUG off"
+#endif
 
 #define HEARTBEAT_INTERVAL 300000 // 5 Minutes
 #define CLOUD_UPDATE 60000        // 1 Minutes
 #define FLASH_STUM 3000           // 3 Secunds
+#define RELAY_INTERVAL 100        // 10 Hz
+#define DISPLAY_INTERVAL 200      // 5 Hz
+#define PERSIST_INTERVAL 1000
+#define LED_BLINK 500
+#define WIFI_CONNECT_TIMEOUT 30000 // saved network silent this long: open the portal
+#define INJECT_FRAME 512 // longest JSON frame accepted on Serial
+
+#define HYSTERESIS 1.0       // degrees around the point
+#define MIN_ON_TIME 180000   // 3 Minutes
+#define MIN_OFF_TIME 180000  // 3 Minutes
+#define FAN_OVERRUN 30000    // 30 Secunds
+#define TEMPERATURE_DEADBAND 0.2
 
 #define DEFAULT_SCALE "CELSIUS"
 #define DHTTYPE DHT11
@@ -32,14 +68,37 @@
 #define PIN_IR D7
 #define PIN_DHT D9
 
-uint64_t heartbeatTimestamp = 0, cloudLastUpdateST = 0, stum = 0, now;
-bool isPersist = false, isConnected = false, isWifiReseted = false;
+uint64_t stum = 0, now;
+bool isPersist = false, isWifiReseted = false, isTelemetry = false, ledBlink = false, isCloudStarted = false;
 
 
 
 uint eeAddr = 500, eeAddr2 = 500;
 int btnWifiReset = 0, debugRead = 99999;
 
+#if DEBUG
+struct
+{
+  uint32_t count = 0, total = 0, min = UINT32_MAX, max = 0, buckets[24] = {0};
+  uint32_t heapMin = UINT32_MAX, heapDrops = 0;
+} loopStats;
+// Cloud path: frames injected on Serial, how long until the relay task
+// acted on them, and what went back out on the socket.
+struct
+{
+  bool pending = false;
+  uint8_t outputs = 0;
+  uint32_t injectedAt = 0, injected = 0, total = 0, max = 0, relayChanges = 0;
+  uint32_t frames = 0, bytes = 0, failures = 0;
+} cloudStats;
+// Boot milestones, us since reset: first relay decision, first one made
+// on a sensor reading, WiFi associated, sinric.com connected.
+struct
+{
+  uint32_t control = 0, reading = 0, wifi = 0, cloud = 0;
+} bootStats;
+#endif
+
 struct
 {
   char deviceId[30], apiKey[50];
@@ -50,162 +109,525 @@ struct
   ThermostatState state;
 } data;
 
-DHT dht(PIN_DHT, DHTTYPE);
+ThermostatDHT dht(PIN_DHT, DHTTYPE);
+ThermostatSensor sensor(&dht);
 WiFiManager wifiManager;
 WebSocketsClient webSocket;
 WiFiManagerParameter
     sinricApiKey("sinric_apiKey", "Sinric Api Key", "", 50),
     sinricDeviceId("sinric_devId", "Sinric Device ID", "", 30);
-Thermostat termostato(PIN_FAN, PIN_COOL, PIN_HEAT);
 ThermostatIRCtrls control(PIN_IR);
 ThermostatDisplay display(PIN_SDA, PIN_SCL);
+ThermostatScheduler scheduler;
+ThermostatJournal journal(sizeof(data) + sizeof(sinric));
+ThermostatOutbox outbox;
+ThermostatNetwork network;
+#if SIMULATE
+ThermostatSimulation simulation;
+#endif
+#if PROFILE
+ThermostatProfiler profiler;
+#endif
+#if TRACE
+ThermostatTraceWriter trace(&Serial);
+#endif
 
-void setPowerStateOnServer(String deviceId, String value);
-void setSetTemperatureSettingOnServer(String deviceId, float setPoint, String scale, float ambientTemperature, float ambientHumidity);
-void setThermostatModeOnServer(String deviceId, String thermostatMode);
+bool setPowerStateOnServer(const char *deviceId, const char *value);
+bool setSetTemperatureSettingOnServer(const char *deviceId, float setPoint, const char *scale, float ambientTemperature, float ambientHumidity);
+bool setThermostatModeOnServer(const char *deviceId, const char *thermostatMode);
+bool sendToServer(ThermostatOutbox::Kind kind);
+bool sendFrame(const char *frame, size_t length);
 void webSocketEvent(WStype_t type, uint8_t *payload, size_t length);
+void onSetpointCommand(const JsonView &value);
+void onSetModeCommand(const JsonView &value);
+void onTestCommand(const JsonView &value);
 void onChange(ThermostatIRCtrls::TCSpeed speed, ThermostatIRCtrls::TCTab tab, ThermostatIRCtrls::TCMode mode, int temp);
 float onChangeTemp(float oldTmp, float newTmp);
 float onChangePoint(float oldP, float newP);
 void onStum(ButtonInformation *sender);
 ThermostatState onChangeStatus(ThermostatState oldST, ThermostatState newST);
 void saveConfigCallback();
+bool restore();
+void persist();
+
+// The change handlers below, bound at compile time: runner() calls them
+// directly instead of through std::function.
+struct ThermostatHooks : ThermostatNoHooks
+{
+  ThermostatState onStateChange(ThermostatState oldST, ThermostatState newST) { return onChangeStatus(oldST, newST); }
+  float onPointChange(float oldP, float newP) { return onChangePoint(oldP, newP); }
+  float onTemperatureChange(float oldTmp, float newTmp) { return onChangeTemp(oldTmp, newTmp); }
+};
+BasicThermostat<ThermostatHooks> termostato(PIN_FAN, PIN_COOL, PIN_HEAT);
+
+void runRelays();
+uint64_t controlMillis();
+void runDisplay();
+void runPersist();
+void runLed();
+void runTelemetry();
+void runHeartbeat();
+void runWifi();
+void startCloud();
+void onNetworkChange(uint8_t changes);
+#if DEBUG
+void runDebug();
+void injectFrame();
+void printLoopStats();
+#endif
+#if DEBUG && PROFILE
+void printProfile();
+void sendProfile();
+#endif
 
 void setup()
 {
-  ButtonEvent.addButton(PIN_BTN);
-  ButtonEvent.setStumEvent(PIN_BTN, onStum);
+  ButtonHandle flashButton = ButtonEvent.addButton(PIN_BTN);
+  ButtonEvent.setStumEvent(flashButton, onStum);
+  ButtonEvent.setInterruptMode(true);
 
   pinMode(PIN_LED, OUTPUT);
   digitalWrite(PIN_LED, HIGH);
 
-#if DEBUG
+#if DEBUG || TRACE
   Serial.begin(115200);
 #endif
-  display.begin();
+  // stage 1: persisted state and relay control, nothing here waits on I/O
   EEPROM.begin(4096);
-  EEPROM.get(eeAddr, data);
   eeAddr2 = eeAddr + sizeof(data);
-  EEPROM.get(eeAddr2, sinric);
+  if (!journal.begin() || !restore())
+  {
+    EEPROM.get(eeAddr, data);
+    EEPROM.get(eeAddr2, sinric);
+  }
+  if (isnan(data.pointTemp))
+  {
+    data.pointTemp = 20;
+    isPersist = true;
+  }
+
+  sensor.begin();
+  termostato.begin();
+  termostato.setHysteresis(HYSTERESIS);
+  termostato.setMinOnTime(MIN_ON_TIME);
+  termostato.setMinOffTime(MIN_OFF_TIME);
+  termostato.setFanOverrun(FAN_OVERRUN);
+  termostato.setTemperatureDeadband(TEMPERATURE_DEADBAND);
+  outbox.setSender(sendToServer);
+  runRelays();
+
+  // stage 2: local peripherals; a missing one is skipped, not waited for
+  if (!display.begin())
+  {
+#if DEBUG
+    Serial.println(F("SSD1306 not found, running without display"));
+#endif
+  }
+  control.setOnChange(onChange);
+  control.begin();
 
+  // stage 3: WiFi, the captive portal and the cloud come up from the loop
   sinricApiKey.setValue(sinric.apiKey, 50);
   sinricDeviceId.setValue(sinric.deviceId, 30);
   wifiManager.addParameter(&sinricApiKey);
   wifiManager.addParameter(&sinricDeviceId);
   wifiManager.setSaveConfigCallback(saveConfigCallback);
-
-  if (WiFi.status() == WL_CONNECT_FAILED || WiFi.SSID().isEmpty())
+  wifiManager.setConfigPortalBlocking(false);
+  wifiManager.setDebugOutput(DEBUG);
+  network.begin();
+  network.setOnChange(onNetworkChange);
+  if (!network.hasSavedNetwork())
   {
+    wifiManager.startConfigPortal(WIFI_SSID, WIFI_PASS);
     display.setWifi(WIFI_SSID);
     display.showApModeScreen();
   }
   else
   {
-    display.setWifi(WiFi.SSID());
+    display.setWifi(network.getSsid());
     display.showLoaderScreen();
   }
-
-  wifiManager.autoConnect(WIFI_SSID, WIFI_PASS);
-  wifiManager.setDebugOutput(DEBUG);
-
-  display.setWifi(WiFi.SSID());
-  display.showLoaderScreen();
-
-  webSocket.begin("iot.sinric.com", 80, "/");
   webSocket.onEvent(webSocketEvent);
-  webSocket.setAuthorization("apikey", sinric.apiKey);
-  webSocket.setReconnectInterval(5000);
 
-  dht.begin();
-  termostato.begin();
-  termostato.setOnStateChange(onChangeStatus);
-  termostato.setOnPointChange(onChangePoint);
-  termostato.setOnTemperatureChange(onChangeTemp);
-  control.setOnChange(onChange);
-  control.begin();
+  // name, task, period (ms), priority, budget (us)
+  scheduler.add("ir", []() { control.loop(); }, 0, 0, 2000);
+  scheduler.add("buttons", []() { ButtonEvent.loop(); }, 0, 0, 500);
+  scheduler.add("socket", []() { if (isCloudStarted) webSocket.loop(); }, 0, 1, 10000);
+  scheduler.add("wifi", runWifi, 0, 5, 20000);
+  scheduler.add("network", []() { network.loop(); }, 0, 5, 1000);
+  scheduler.add("relays", runRelays, RELAY_INTERVAL, 1, 1000);
+  scheduler.add("sensor", []() { sensor.loop(); }, 0, 2, 1000);
+  scheduler.add("display", runDisplay, DISPLAY_INTERVAL, 3, 5000);
+  scheduler.add("oled", []() { display.transfer(); }, 0, 3, 1500);
+  scheduler.add("persist", runPersist, PERSIST_INTERVAL, 4, 50000);
+  scheduler.add("led", runLed, LED_BLINK, 4);
+  scheduler.add("telemetry", runTelemetry, CLOUD_UPDATE, 5);
+  scheduler.add("outbox", []() { outbox.loop(); }, 0, 5, 20000);
+  scheduler.add("heartbeat", runHeartbeat, HEARTBEAT_INTERVAL, 5);
+#if DEBUG
+  scheduler.add("debug", runDebug, 100, 6);
+#endif
+#if PROFILE
+  scheduler.setProfiler(&profiler);
+#endif
+#if TRACE
+  sensor.setOnSample([](float temperature, float humidity) { trace.sensor(temperature, humidity); });
+  control.setOnFrame([](const decode_results *results) { trace.ir(results); });
+  ButtonEvent.setEdgeEvent([](const ButtonEdge *edge) { trace.button(edge); });
+  trace.begin();
+#endif
 
 #if DEBUG
   Serial.printf("Store -> \n\tPoint: %f\n", data.pointTemp);
-  Serial.printf("\tState: %s\n", Thermostat::stateToStr(data.state).c_str());
+  Serial.printf("\tState: %s\n", Thermostat::stateToStr(data.state));
   Serial.printf("\tSinric api key: %s\n", sinric.apiKey);
   Serial.printf("\tSinric device Id: %s\n", sinric.deviceId);
 #endif
-
-  if (isnan(data.pointTemp))
-  {
-    data.pointTemp = 20;
-    EEPROM.put(eeAddr, data);
-  }
   digitalWrite(PIN_LED, LOW);
 }
 
 void loop()
 {
+#if DEBUG
+  uint32_t loopStart = micros(), heapStart = ESP.getFreeHeap();
+#endif
   now = millis();
-  display.setWifi(WiFi.SSID());
+  scheduler.loop();
+#if PROFILE
+  profiler.mark();
+#endif
 
-  display.setWifi(WiFi.SSID());
-  display.setEnable(!termostato.isOff());
+#if DEBUG
+  uint32_t elapsed = micros() - loopStart, heapEnd = ESP.getFreeHeap();
+  loopStats.count++;
+  loopStats.total += elapsed;
+  loopStats.min = min(loopStats.min, elapsed);
+  loopStats.max = max(loopStats.max, elapsed);
+  loopStats.buckets[min(31 - __builtin_clz(elapsed | 1), 23)]++;
+  loopStats.heapMin = min(loopStats.heapMin, heapEnd);
+  if (heapEnd < heapStart)
+    loopStats.heapDrops++;
+#endif
+}
+
+void runRelays()
+{
+#if SIMULATE
+  uint64_t now = controlMillis();
+  simulation.step(termostato.getRelays()->getOutputs(), termostato.getState(), data.pointTemp, now);
+  termostato.runner(data.state, data.pointTemp, simulation.getTemperature(), (unsigned long)now);
+#else
+  termostato.runner(data.state, data.pointTemp, sensor.getTemperature());
+#endif
+#if DEBUG
+  if (bootStats.control == 0)
+    bootStats.control = micros();
+  if (bootStats.reading == 0 && sensor.isValid())
+    bootStats.reading = micros();
+  if (cloudStats.pending)
+  {
+    uint32_t elapsed = micros() - cloudStats.injectedAt;
+    cloudStats.pending = false;
+    cloudStats.total += elapsed;
+    if (elapsed > cloudStats.max)
+      cloudStats.max = elapsed;
+    if (termostato.getRelays()->getOutputs() != cloudStats.outputs)
+      cloudStats.relayChanges++;
+  }
+#endif
+}
+
+// Clock the control loop runs on; sped up when simulating. The sped-up
+// clock adds up millis() deltas in 64 bits: a plain product would wrap
+// after 2^32 / SIMULATE_SPEED ms. The engine takes the low 32 bits, and
+// differences of those stay right across the wrap.
+uint64_t controlMillis()
+{
+#if SIMULATE
+  static uint32_t last = millis();
+  static uint64_t total = 0;
+  uint32_t now = millis();
+  total += (uint64_t)(now - last) * SIMULATE_SPEED;
+  last = now;
+  return total;
+#else
+  return millis();
+#endif
+}
+
+void runDisplay()
+{
+  bool portal = wifiManager.getConfigPortalActive();
+  display.setEnable(portal || !termostato.isOff());
+  if (portal)
+  {
+    display.showApModeScreen();
+    return;
+  }
+  display.loop();
+}
+
+// Drives the non-blocking WiFiManager: the cloud is started once the
+// station is up, and until then the portal opens when there is no saved
+// network or it has not answered within WIFI_CONNECT_TIMEOUT, as the boot
+// time autoConnect() did.
+void runWifi()
+{
+  wifiManager.process();
+  if (network.isWifiConnected())
+  {
+    if (!isCloudStarted)
+      startCloud();
+    return;
+  }
+  if (!isCloudStarted && !wifiManager.getConfigPortalActive() && (!network.hasSavedNetwork() || network.getDownTime() > WIFI_CONNECT_TIMEOUT))
+  {
+    wifiManager.startConfigPortal(WIFI_SSID, WIFI_PASS);
+    display.setWifi(WIFI_SSID);
+  }
+}
 
+void startCloud()
+{
+#if DEBUG
+  bootStats.wifi = micros();
+#endif
+  webSocket.begin("iot.sinric.com", 80, "/");
+  webSocket.setAuthorization("apikey", sinric.apiKey);
+  webSocket.setReconnectInterval(network.getBackoff());
+  isCloudStarted = true;
+}
+
+// Transitions only: the display learns the SSID when the station changes,
+// the cloud retries soon (with jitter) once the station is back, and the
+// outbox follows the cloud socket.
+void onNetworkChange(uint8_t changes)
+{
+#if TRACE
+  if (changes & NETWORK_WIFI)
+    trace.wifi(network.isWifiConnected(), network.getRssi(), network.getSsid());
+#endif
+  if ((changes & NETWORK_WIFI) && !wifiManager.getConfigPortalActive())
+    display.setWifi(network.getSsid());
+  if ((changes & NETWORK_WIFI) && network.isWifiConnected() && isCloudStarted && !network.isCloudConnected())
+    webSocket.setReconnectInterval(network.getBackoff());
+  if (changes & NETWORK_CLOUD)
+  {
+    outbox.setConnected(network.isCloudConnected());
+    if (network.isCloudConnected())
+      outbox.replay();
+  }
+}
+
+void runPersist()
+{
   if (isPersist)
   {
-    EEPROM.put(eeAddr, data);
-    EEPROM.commit();
+    persist();
     isPersist = false;
+  }
+  journal.loop();
+}
+
+bool restore()
+{
+  uint8_t record[sizeof(data) + sizeof(sinric)];
+  if (!journal.read(record))
+    return false;
+  memcpy(&data, record, sizeof(data));
+  memcpy(&sinric, record + sizeof(data), sizeof(sinric));
+  return true;
+}
+
+// Hands the state to the journal, which writes it once changes settle.
+// Without a filesystem flash area it falls back to the EEPROM sector.
+void persist()
+{
+  if (journal.isReady())
+  {
+    uint8_t record[sizeof(data) + sizeof(sinric)];
+    memcpy(record, &data, sizeof(data));
+    memcpy(record + sizeof(data), &sinric, sizeof(sinric));
+    journal.write(record);
+    return;
+  }
+  EEPROM.put(eeAddr, data);
+  EEPROM.put(eeAddr2, sinric);
+  EEPROM.commit();
 #if DEBUG
-    Serial.println("-> Save data!");
+  Serial.println("-> Save data!");
 #endif
-  }
+}
 
-  display.setEnable(!termostato.isOff());
+void runLed()
+{
+  ledBlink = !ledBlink;
   if (termostato.isOff())
     digitalWrite(PIN_LED, LOW);
-  else if (termostato.isStandby() && (now % 1000) <= 500)
+  else if (termostato.isStandby() && ledBlink)
     digitalWrite(PIN_LED, LOW);
   else
     digitalWrite(PIN_LED, HIGH);
+}
+
+void runTelemetry()
+{
+  if (!isTelemetry)
+    return;
+  outbox.post(ThermostatOutbox::SETTING);
+  isTelemetry = false;
+}
+
+void runHeartbeat()
+{
+  if (network.isCloudConnected())
+    webSocket.sendTXT("H");
+}
 
 #if DEBUG
-  if (Serial.available() > 0)
+void runDebug()
+{
+  if (Serial.available() <= 0)
+    return;
+  if (Serial.peek() == '{')
   {
-    debugRead = Serial.parseInt();
-    if (debugRead == 99)
-    {
-      wifiManager.resetSettings();
-    }
-    else if (debugRead == 1)
-    {
-      data.state = ThermostatState::OFF;
-    }
-    else if (debugRead == 2)
-    {
-      data.state = ThermostatState::HEAT;
-    }
-    else if (debugRead == 3)
-    {
-      data.state = ThermostatState::COOL;
-    }
-    else if (debugRead >= 10 && debugRead <= 40)
-    {
-      data.pointTemp = debugRead;
-    }
-    debugRead = 99999;
+    injectFrame();
+    return;
+  }
+  debugRead = Serial.parseInt();
+  if (debugRead == 99)
+  {
+    wifiManager.resetSettings();
+    network.forget();
+  }
+  else if (debugRead == 1)
+  {
+    data.state = ThermostatState::OFF;
+  }
+  else if (debugRead == 2)
+  {
+    data.state = ThermostatState::HEAT;
+  }
+  else if (debugRead == 3)
+  {
+    data.state = ThermostatState::COOL;
+  }
+  else if (debugRead == 98)
+  {
+    printLoopStats();
+  }
+#if PROFILE
+  else if (debugRead == 97)
+  {
+    printProfile();
+  }
+  else if (debugRead == 96)
+  {
+    sendProfile();
   }
 #endif
+  else if (debugRead >= 10 && debugRead <= 40)
+  {
+    data.pointTemp = debugRead;
+  }
+  debugRead = 99999;
+}
 
-  control.loop();
-  webSocket.loop();
-  termostato.runner(data.state, data.pointTemp, dht.readTemperature());
-  display.loop();
-  ButtonEvent.loop();
+// Feeds one JSON line from Serial to webSocketEvent as if sinric.com sent
+// it, so the command path can be exercised and timed without the server.
+void injectFrame()
+{
+  static char frame[INJECT_FRAME];
+  size_t length = Serial.readBytesUntil('\n', frame, sizeof(frame) - 1);
+  while (length > 0 && frame[length - 1] == '\r')
+    length--;
+  frame[length] = '\0';
+  cloudStats.outputs = termostato.getRelays()->getOutputs();
+  cloudStats.injectedAt = micros();
+  cloudStats.pending = true;
+  cloudStats.injected++;
+  webSocketEvent(WStype_TEXT, (uint8_t *)frame, length);
+}
+
+// Prints loop latency (us) since the last call: min/avg/max and the
+// percentiles read from the log2 histogram, plus heap pressure.
+void printLoopStats()
+{
+  if (loopStats.count == 0)
+    return;
+  uint32_t p[3] = {0}, rank[3] = {loopStats.count / 2, loopStats.count * 9 / 10, loopStats.count * 99 / 100}, seen = 0;
+  for (int b = 0, r = 0; b < 24 && r < 3; b++)
+  {
+    seen += loopStats.buckets[b];
+    while (r < 3 && seen > rank[r])
+      p[r++] = 2u << b;
+  }
+  Serial.printf("Loop -> \n\tIterations: %u\n", loopStats.count);
+  Serial.printf("\tBoot us: first relay decision %u, on a reading %u, wifi %u, cloud %u\n", bootStats.control, bootStats.reading, bootStats.wifi, bootStats.cloud);
+  Serial.printf("\tLatency us: min %u avg %u max %u\n", loopStats.min, loopStats.total / loopStats.count, loopStats.max);
+  Serial.printf("\tPercentiles us (<=): p50 %u p90 %u p99 %u\n", p[0], p[1], p[2]);
+  Serial.printf("\tHeap: min free %u, loops losing heap %u\n", loopStats.heapMin, loopStats.heapDrops);
+  Serial.printf("\tSensor: %u reads, %u bad frames, %u cached hits, loop us total %u max %u, age %lu ms\n", sensor.getReads(), sensor.getErrors(), sensor.getHits(), sensor.getReadMicros(), sensor.getMaxReadMicros(), sensor.getAge());
+  Serial.printf("\tJournal: %u commits, %u coalesced, %u erases, commit us last %u max %u\n", journal.getCommits(), journal.getCoalesced(), journal.getErases(), journal.getCommitMicros(), journal.getMaxCommitMicros());
+  Serial.printf("\tOutbox: %u posted, %u sent, %u coalesced, %u dropped, %u throttled\n", outbox.getPosted(), outbox.getSent(), outbox.getCoalesced(), outbox.getDropped(), outbox.getThrottled());
+  Serial.printf("\tCloud: %u injected, command to relay task us avg %u max %u, %u relay changes\n", cloudStats.injected, cloudStats.injected ? cloudStats.total / cloudStats.injected : 0, cloudStats.max, cloudStats.relayChanges);
+  Serial.printf("\tNetwork: wifi %s '%s' %d dBm, cloud %s, %u wifi drops, %u cloud drops, %u reconnect attempts\n", network.isWifiConnected() ? "up" : "down", network.getSsid(), network.getRssi(), network.isCloudConnected() ? "up" : "down", network.getWifiDrops(), network.getCloudDrops(), network.getAttempts());
+  Serial.printf("\tSocket: %u frames, %u bytes sent, %u failed\n", cloudStats.frames, cloudStats.bytes, cloudStats.failures);
+  Serial.printf("\tButtons: %lu edges lost\n", ButtonEvent.getOverflows());
+  Serial.printf("\tCycles: %u (%.1f per hour), %u relay transitions\n", termostato.getCycles(), termostato.getCyclesPerHour(controlMillis()), termostato.getTransitions());
+#if SIMULATE
+  Serial.printf("\tSimulation: %.2f C after %lu s, compressor %lu s, fan %lu s, %.1f Wh, comfort error %.2f C\n", simulation.getTemperature(), (unsigned long)(simulation.getElapsed() / 1000), (unsigned long)(simulation.getCompressorMillis() / 1000), (unsigned long)(simulation.getFanMillis() / 1000), simulation.getEnergy(), simulation.getComfortError());
+#endif
+  Serial.printf("\tRelays: %u requested, %u written, %u interlocks\n", termostato.getRelays()->getRequests(), termostato.getRelays()->getWrites(), termostato.getRelays()->getInterlocks());
+  Serial.printf("\tDisplay: %u frames sent, %u skipped, %u I2C bytes, %.1f fps, transfer us avg %u max %u\n", display.getFramesSent(), display.getFramesSkipped(), display.getBytesSent(), display.getFramesPerSecond(), display.getTransferMicros(), display.getMaxTransferMicros());
+  for (uint8_t i = 0; i < scheduler.getCount(); i++)
+  {
+    const ThermostatScheduler::Task &task = scheduler.getTask(i);
+    Serial.printf("\tTask %s: %u runs, us avg %u max %u, %u overruns, %u late\n", task.name, task.runs, task.runs ? task.totalMicros / task.runs : 0, task.maxMicros, task.overruns, task.late);
+  }
+  scheduler.resetStats();
+  loopStats = {};
+}
+#endif
+
+#if DEBUG && PROFILE
+// Per-task cycle profile since the last call, in us, with the log2
+// histogram printed as "bucket upper bound:count" pairs.
+void printProfile()
+{
+  Serial.printf("Profile -> \n\tLoops: %u (%.1f Hz), worst %u us\n", profiler.getLoops(), profiler.getLoopsPerSecond(), profiler.getMaxLoopMicros());
+  for (uint8_t i = 0; i < profiler.getCount(); i++)
+  {
+    const ThermostatProfiler::Phase &phase = profiler.getPhase(i);
+    if (phase.count == 0)
+      continue;
+    Serial.printf("\t%s: %u runs, us min %u avg %u max %u |", phase.name, phase.count, profiler.toMicros(phase.min), profiler.toMicros(phase.total / phase.count), profiler.toMicros(phase.max));
+    for (uint8_t b = 0; b < PROFILER_BUCKETS; b++)
+      if (phase.buckets[b] > 0)
+        Serial.printf(" %u:%u", profiler.toMicros(2ULL << b), phase.buckets[b]);
+    Serial.println();
+  }
+  profiler.reset();
 }
 
+// Same profile as one JSON message on the socket.
+void sendProfile()
+{
+  static char frame[INJECT_FRAME];
+  size_t length = profiler.format(frame, sizeof(frame));
+  if (length > 0)
+    sendFrame(frame, length);
+}
+#endif
+
 void saveConfigCallback()
 {
   strcpy(sinric.apiKey, sinricApiKey.getValue());
   strcpy(sinric.deviceId, sinricDeviceId.getValue());
-  EEPROM.put(eeAddr2, sinric);
   isPersist = true;
+#if TRACE
+  trace.portal(sinric.deviceId);
+#endif
 }
 
 void onStum(ButtonInformation *sender)
@@ -213,7 +635,7 @@ void onStum(ButtonInformation *sender)
 #if DEBUG
   Serial.println("-> Flash Stuned");
 #endif
-  if (termostato.isOff() && !WiFi.SSID().isEmpty())
+  if (termostato.isOff() && network.hasSavedNetwork())
   {
     for (size_t i = 0; i < 10; i++)
     {
@@ -221,6 +643,7 @@ void onStum(ButtonInformation *sender)
       delay(500);
     }
     wifiManager.resetSettings();
+    network.forget();
 #if DEBUG
     Serial.println("-> Wifi reset");
 #endif
@@ -229,11 +652,10 @@ void onStum(ButtonInformation *sender)
 
 ThermostatState onChangeStatus(ThermostatState oldST, ThermostatState newST)
 {
-  String st = Thermostat::stateToStr(newST).c_str();
-  if (isConnected)
-    setThermostatModeOnServer(sinric.deviceId, st);
+  outbox.post(ThermostatOutbox::MODE);
 #if DEBUG
-  Serial.printf("->State change: %s -> %s\n", Thermostat::stateToStr(oldST).c_str(), st.c_str());
+  const char *st = Thermostat::stateToStr(newST);
+  Serial.printf("->State change: %s -> %s\n", Thermostat::stateToStr(oldST), st);
 #endif
   isPersist = true;
   data.state = newST;
@@ -243,8 +665,7 @@ ThermostatState onChangeStatus(ThermostatState oldST, ThermostatState newST)
 
 float onChangePoint(float oldP, float newP)
 {
-  if (isConnected)
-    setSetTemperatureSettingOnServer(sinric.deviceId, newP, DEFAULT_SCALE, dht.readTemperature(), dht.readHumidity());
+  outbox.post(ThermostatOutbox::SETTING);
 #if DEBUG
   Serial.printf("->Point change: %f -> %f\n", oldP, newP);
 #endif
@@ -256,15 +677,10 @@ float onChangePoint(float oldP, float newP)
 
 float onChangeTemp(float oldTmp, float newTmp)
 {
-  if (((int)oldTmp) == ((int)newTmp))
-    return oldTmp;
-  int hum = dht.readHumidity();
+  // NaN until the first good frame; the display shows it as "--"
+  float hum = sensor.getHumidity();
 
-  if (isConnected && (now - cloudLastUpdateST) > CLOUD_UPDATE)
-  {
-    setSetTemperatureSettingOnServer(sinric.deviceId, data.pointTemp, DEFAULT_SCALE, newTmp, hum);
-    cloudLastUpdateST = now;
-  }
+  isTelemetry = true;
   display.setTemperature(newTmp);
   display.setHumidity(hum);
 #if DEBUG
@@ -285,7 +701,7 @@ void onChange(ThermostatIRCtrls::TCSpeed speed, ThermostatIRCtrls::TCTab tab, Th
     data.state = ThermostatState::HEAT;
     break;
   case ThermostatIRCtrls::AUTO:
-    if (dht.readTemperature() > data.pointTemp)
+    if (sensor.getTemperature() > data.pointTemp)
       data.state = ThermostatState::COOL;
     else
       data.state = ThermostatState::HEAT;
@@ -306,160 +722,145 @@ void onChange(ThermostatIRCtrls::TCSpeed speed, ThermostatIRCtrls::TCTab tab, Th
   }
 }
 
+static const ThermostatCommand::Action commands[] = {
+    {ThermostatCommand::hash("action.devices.commands.ThermostatTemperatureSetpoint"), onSetpointCommand},
+    {ThermostatCommand::hash("action.devices.commands.ThermostatSetMode"), onSetModeCommand},
+    {ThermostatCommand::hash("test"), onTestCommand},
+};
+
+void onSetpointCommand(const JsonView &value)
+{
+  JsonView point;
+  if (ThermostatCommand::field(value, "thermostatTemperatureSetpoint", point))
+    data.pointTemp = point.toFloat();
+}
+
+void onSetModeCommand(const JsonView &value)
+{
+  JsonView mode;
+  char state[8];
+  if (!ThermostatCommand::field(value, "thermostatMode", mode))
+    return;
+  mode.copy(state, sizeof(state));
+  data.state = Thermostat::strToState(state);
+}
+
+void onTestCommand(const JsonView &value)
+{
+#if DEBUG
+  Serial.println("[WSc] received test command from sinric.com");
+#endif
+}
+
 void webSocketEvent(WStype_t type, uint8_t *payload, size_t length)
 {
   switch (type)
   {
   case WStype_DISCONNECTED:
-    isConnected = false;
+    network.setCloudConnected(false);
+#if TRACE
+    trace.cloud(false);
+#endif
+    network.countFailure();
+    webSocket.setReconnectInterval(network.getBackoff());
 #if DEBUG
     Serial.printf("[WSc] Webservice disconnected from sinric.com!\n");
 #endif
     break;
   case WStype_CONNECTED:
-    isConnected = true;
+    network.setCloudConnected(true);
+#if TRACE
+    trace.cloud(true);
+#endif
 #if DEBUG
+    if (bootStats.cloud == 0)
+      bootStats.cloud = micros();
     Serial.printf("[WSc] Service connected to sinric.com at url: %s\n", payload);
     Serial.printf("Waiting for commands from sinric.com ...\n");
 #endif
-    setThermostatModeOnServer(sinric.deviceId, Thermostat::stateToStr(data.state));
     break;
   case WStype_TEXT:
   {
-#if DEBUG
-    Serial.printf("[WSc] get text: %s\n", payload);
-#endif
-#if ARDUINOJSON_VERSION_MAJOR == 5
-    DynamicJsonBuffer jsonBuffer;
-    JsonObject &json = jsonBuffer.parseObject((char *)payload);
-#endif
-#if ARDUINOJSON_VERSION_MAJOR == 6
-    DynamicJsonDocument json(1024);
-    deserializeJson(json, (char *)payload);
-#endif
-    String deviceId = json["deviceId"];
-    String action = json["action"];
-    String baseValue = json["value"];
-#if DEBUG
-    Serial.println("[WSc] baseValue: " + baseValue);
+#if TRACE
+    trace.frame(payload, length);
 #endif
-    if (deviceId == String(sinric.deviceId))
-    {
-      if (action == "action.devices.commands.ThermostatTemperatureSetpoint")
-      {
-        String value = json["value"]["thermostatTemperatureSetpoint"];
-        data.pointTemp = value.toFloat();
-      }
-      else if (action == "action.devices.commands.ThermostatSetMode")
-      {
-        String value = json["value"]["thermostatMode"];
-        data.state = Thermostat::strToState(value);
-      }
 #if DEBUG
-      else if (action == "test")
-      {
-        Serial.println("[WSc] received test command from sinric.com");
-      }
+    Serial.printf("[WSc] get text: %s\n", payload);
 #endif
-    }
+    ThermostatCommand::dispatch((const char *)payload, length, sinric.deviceId, commands, sizeof(commands) / sizeof(commands[0]));
   }
   break;
+  case WStype_ERROR:
+    network.countFailure();
+    webSocket.setReconnectInterval(network.getBackoff());
+#if DEBUG
+    Serial.printf("[WSc] ERROR \n");
+#endif
+    break;
 #if DEBUG
   case WStype_BIN:
-    Serial.printf("[WSc] get binary length: %u\n", length);
+    Serial.printf("[WSc] get binary length: %u\n", (unsigned)length);
     break;
-  case WStype_ERROR:
-    Serial.printf("[WSc] ERROR \n");
+#endif
   default:
     break;
-#endif
   }
 }
 
-void setPowerStateOnServer(String deviceId, String value)
+// Encodes the newest state of a queued update kind when the outbox sends it.
+bool sendToServer(ThermostatOutbox::Kind kind)
 {
-#if ARDUINOJSON_VERSION_MAJOR == 5
-  DynamicJsonBuffer jsonBuffer;
-  JsonObject &root = jsonBuffer.createObject();
-#endif
-#if ARDUINOJSON_VERSION_MAJOR == 6
-  DynamicJsonDocument root(1024);
-#endif
-  root["deviceId"] = deviceId;
-  root["action"] = "setPowerState";
-  root["value"] = value;
-  StreamString databuf;
-#if ARDUINOJSON_VERSION_MAJOR == 5
-  root.printTo(databuf);
-#endif
-#if ARDUINOJSON_VERSION_MAJOR == 6
-  serializeJson(root, databuf);
-#endif
-#if DEBUG
-  Serial.println("[Ws] Power state change!");
-#endif
-  webSocket.sendTXT(databuf);
+  switch (kind)
+  {
+  case ThermostatOutbox::MODE:
+    return setThermostatModeOnServer(sinric.deviceId, Thermostat::stateToStr(data.state));
+  case ThermostatOutbox::SETTING:
+    return setSetTemperatureSettingOnServer(sinric.deviceId, data.pointTemp, DEFAULT_SCALE, sensor.getTemperature(), sensor.getHumidity());
+  default:
+    return false;
+  }
 }
 
-void setSetTemperatureSettingOnServer(String deviceId, float setPoint, String scale, float ambientTemperature, float ambientHumidity)
+bool sendFrame(const char *frame, size_t length)
 {
-#if ARDUINOJSON_VERSION_MAJOR == 5
-  DynamicJsonBuffer jsonBuffer;
-  JsonObject &root = jsonBuffer.createObject();
-#endif
-#if ARDUINOJSON_VERSION_MAJOR == 6
-  DynamicJsonDocument root(1024);
+  bool sent = webSocket.sendTXT(frame, length);
+#if DEBUG
+  if (sent)
+  {
+    cloudStats.frames++;
+    cloudStats.bytes += length;
+  }
+  else
+    cloudStats.failures++;
 #endif
-  root["action"] = "SetTemperatureSetting";
-  root["deviceId"] = deviceId;
+  return sent;
+}
 
-#if ARDUINOJSON_VERSION_MAJOR == 5
-  JsonObject &valueObj = root.createNestedObject("value");
-  JsonObject &temperatureSetting = valueObj.createNestedObject("temperatureSetting");
-#endif
-#if ARDUINOJSON_VERSION_MAJOR == 6
-  JsonObject valueObj = root.createNestedObject("value");
-  JsonObject temperatureSetting = valueObj.createNestedObject("temperatureSetting");
+// The senders encode into a local before calling sendFrame(): the encoders
+// set length(), and argument evaluation order is unspecified.
+bool setPowerStateOnServer(const char *deviceId, const char *value)
+{
+#if DEBUG
+  Serial.println("[Ws] Power state change!");
 #endif
-  temperatureSetting["setPoint"] = setPoint;
-  temperatureSetting["scale"] = scale;
-  temperatureSetting["ambientTemperature"] = ambientTemperature;
-  temperatureSetting["ambientHumidity"] = ambientHumidity;
+  const char *frame = ThermostatTelemetry::powerState(deviceId, value);
+  return sendFrame(frame, ThermostatTelemetry::length());
+}
 
-  StreamString databuf;
-#if ARDUINOJSON_VERSION_MAJOR == 5
-  root.printTo(databuf);
-#endif
-#if ARDUINOJSON_VERSION_MAJOR == 6
-  serializeJson(root, databuf);
-#endif
+bool setSetTemperatureSettingOnServer(const char *deviceId, float setPoint, const char *scale, float ambientTemperature, float ambientHumidity)
+{
 #if DEBUG
   Serial.println("[Ws] Temperature and humidity sended!");
 #endif
-  webSocket.sendTXT(databuf);
+  const char *frame = ThermostatTelemetry::temperatureSetting(deviceId, setPoint, scale, ambientTemperature, ambientHumidity);
+  return sendFrame(frame, ThermostatTelemetry::length());
 }
 
-void setThermostatModeOnServer(String deviceId, String thermostatMode)
+bool setThermostatModeOnServer(const char *deviceId, const char *thermostatMode)
 {
-#if ARDUINOJSON_VERSION_MAJOR == 5
-  DynamicJsonBuffer jsonBuffer;
-  JsonObject &root = jsonBuffer.createObject();
-#endif
-#if ARDUINOJSON_VERSION_MAJOR == 6
-  DynamicJsonDocument root(1024);
-#endif
-  root["deviceId"] = deviceId;
-  root["action"] = "SetThermostatMode";
-  root["value"] = thermostatMode;
-  StreamString databuf;
-#if ARDUINOJSON_VERSION_MAJOR == 5
-  root.printTo(databuf);
-#endif
-#if ARDUINOJSON_VERSION_MAJOR == 6
-  serializeJson(root, databuf);
-#endif
 #if DEBUG
   Serial.println("[Ws] Thermostat mode change!");
 #endif
-  webSocket.sendTXT(databuf);
+  const char *frame = ThermostatTelemetry::thermostatMode(deviceId, thermostatMode);
+  return sendFrame(frame, ThermostatTelemetry::length());
 }
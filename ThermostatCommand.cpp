@@ -0,0 +1,155 @@
+#include "ThermostatCommand.h"
+
+bool JsonView::equals(const char *text) const
+{
+  return strlen(text) == length && memcmp(text, data, length) == 0;
+}
+
+size_t JsonView::copy(char *out, size_t size) const
+{
+  size_t n = min(length, size - 1);
+  memcpy(out, data, n);
+  out[n] = 0;
+  return n;
+}
+
+float JsonView::toFloat() const
+{
+  char number[16];
+  copy(number, sizeof(number));
+  return atof(number);
+}
+
+uint32_t ThermostatCommand::hash(const JsonView &text)
+{
+  uint32_t h = 2166136261u;
+  for (size_t i = 0; i < text.length; i++)
+    h = (h ^ (uint8_t)text.data[i]) * 16777619u;
+  return h;
+}
+
+bool ThermostatCommand::dispatch(const char *payload, size_t length, const char *deviceId, const Action *actions, uint8_t count)
+{
+  const char *p = payload, *end = payload + length;
+  JsonView key, value, device = {NULL, 0}, action = {NULL, 0}, argument = {NULL, 0};
+  if (!open(p, end))
+    return false;
+  while (next(p, end, key, value))
+  {
+    if (key.equals("deviceId"))
+      device = value;
+    else if (key.equals("action"))
+      action = value;
+    else if (key.equals("value"))
+      argument = value;
+  }
+  if (device.data == NULL || !device.equals(deviceId))
+    return false;
+
+  uint32_t h = hash(action);
+  for (uint8_t i = 0; i < count; i++)
+  {
+    if (actions[i].hash == h)
+    {
+      actions[i].handler(argument);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ThermostatCommand::field(const JsonView &object, const char *key, JsonView &value)
+{
+  const char *p = object.data, *end = object.data + object.length;
+  JsonView name;
+  if (!open(p, end))
+    return false;
+  while (next(p, end, name, value))
+  {
+    if (name.equals(key))
+      return true;
+  }
+  return false;
+}
+
+bool ThermostatCommand::open(const char *&p, const char *end)
+{
+  p = skipSpace(p, end);
+  if (p >= end || *p != '{')
+    return false;
+  p++;
+  return true;
+}
+
+// Reads the next "key": value member of the object being walked. String
+// values are returned without their quotes, everything else verbatim.
+bool ThermostatCommand::next(const char *&p, const char *end, JsonView &key, JsonView &value)
+{
+  p = skipSpace(p, end);
+  if (p < end && *p == ',')
+    p = skipSpace(p + 1, end);
+  if (p >= end || *p != '"')
+    return false;
+
+  const char *start = p + 1;
+  p = skipValue(p, end);
+  if (p == NULL)
+    return false;
+  key = {start, (size_t)(p - start - 1)};
+  p = skipSpace(p, end);
+  if (p >= end || *p != ':')
+    return false;
+
+  start = skipSpace(p + 1, end);
+  p = skipValue(start, end);
+  if (p == NULL || p == start)
+    return false;
+  if (*start == '"')
+    value = {start + 1, (size_t)(p - start - 2)};
+  else
+    value = {start, (size_t)(p - start)};
+  return true;
+}
+
+const char *ThermostatCommand::skipSpace(const char *p, const char *end)
+{
+  while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+    p++;
+  return p;
+}
+
+const char *ThermostatCommand::skipValue(const char *p, const char *end)
+{
+  if (p >= end)
+    return p;
+  if (*p == '"')
+  {
+    for (p++; p < end && *p != '"'; p++)
+      if (*p == '\\')
+        p++;
+    return p < end ? p + 1 : NULL;
+  }
+  if (*p == '{' || *p == '[')
+  {
+    int depth = 0;
+    for (; p < end; p++)
+    {
+      if (*p == '"')
+      {
+        const char *closed = skipValue(p, end);
+        if (closed == NULL)
+          return NULL;
+        p = closed - 1;
+        continue;
+      }
+      if (*p == '{' || *p == '[')
+        depth++;
+      else if ((*p == '}' || *p == ']') && --depth == 0)
+        return p + 1;
+    }
+    return NULL;
+  }
+  while (p < end && *p != ',' && *p != '}' && *p != ']' && *p != ' ' && *p != '\r' && *p != '\n' && *p != '\t')
+    p++;
+  return p;
+}
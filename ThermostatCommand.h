@@ -0,0 +1,45 @@
+#ifndef ThermostatCommand_H
+#define ThermostatCommand_H
+
+#include "Arduino.h"
+
+// A slice of the received payload; nothing is copied out of the frame.
+struct JsonView
+{
+  const char *data;
+  size_t length;
+  bool equals(const char *text) const;
+  size_t copy(char *out, size_t size) const;
+  float toFloat() const;
+};
+
+// In-place parser for the Sinric command frames. The top-level object is
+// scanned once for deviceId, action and value; frames for other devices
+// are dropped before anything else happens, and the action is dispatched
+// through a table keyed by a compile-time FNV-1a hash of its name.
+class ThermostatCommand
+{
+public:
+  typedef void (*Handler)(const JsonView &value);
+  struct Action
+  {
+    uint32_t hash;
+    Handler handler;
+  };
+
+  static constexpr uint32_t hash(const char *text, uint32_t h = 2166136261u)
+  {
+    return *text ? hash(text + 1, (h ^ (uint8_t)*text) * 16777619u) : h;
+  }
+  static uint32_t hash(const JsonView &text);
+  static bool field(const JsonView &object, const char *key, JsonView &value);
+  static bool dispatch(const char *payload, size_t length, const char *deviceId, const Action *actions, uint8_t count);
+
+private:
+  static bool open(const char *&p, const char *end);
+  static bool next(const char *&p, const char *end, JsonView &key, JsonView &value);
+  static const char *skipSpace(const char *p, const char *end);
+  static const char *skipValue(const char *p, const char *end);
+};
+
+#endif
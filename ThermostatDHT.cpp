@@ -0,0 +1,117 @@
+#include "ThermostatDHT.h"
+
+ThermostatDHT::ThermostatDHT(uint8_t pin, uint8_t type)
+{
+  _pin = pin;
+  _type = type;
+}
+
+void ThermostatDHT::begin()
+{
+  pinMode(_pin, INPUT_PULLUP);
+  _phaseMillis = millis();
+}
+
+bool ThermostatDHT::isBusy() { return _phase != IDLE; }
+float ThermostatDHT::readTemperature() { return _temperature; }
+float ThermostatDHT::readHumidity() { return _humidity; }
+uint32_t ThermostatDHT::getFrames() { return _frames; }
+uint32_t ThermostatDHT::getErrors() { return _errors; }
+
+bool ThermostatDHT::available()
+{
+  bool fresh = _available;
+  _available = false;
+  return fresh;
+}
+
+bool ThermostatDHT::start()
+{
+  if (_phase != IDLE)
+    return false;
+  pinMode(_pin, OUTPUT);
+  digitalWrite(_pin, LOW);
+  _phaseMillis = millis();
+  _phase = START;
+  return true;
+}
+
+void ThermostatDHT::loop()
+{
+  unsigned long now = millis();
+  if (_phase == START)
+  {
+    // DHT11 needs at least 18 ms of start pulse, DHT22 at least 1 ms
+    if (now - _phaseMillis < (_type == DHT11 ? 20u : 2u))
+      return;
+    _count = 0;
+    _phaseMillis = now;
+    _phase = CAPTURE;
+    attachInterruptArg(digitalPinToInterrupt(_pin), onEdge, this, CHANGE);
+    pinMode(_pin, INPUT_PULLUP);
+  }
+  else if (_phase == CAPTURE)
+  {
+    if (_count < DHT_EDGES && now - _phaseMillis <= DHT_CAPTURE_TIMEOUT)
+      return;
+    detachInterrupt(digitalPinToInterrupt(_pin));
+    _phase = IDLE;
+
+    uint32_t edges[DHT_EDGES];
+    uint8_t count = _count;
+    for (uint8_t i = 0; i < count; i++)
+      edges[i] = _edges[i];
+    if (decode(edges, count, _type, _temperature, _humidity))
+    {
+      _frames++;
+      _available = true;
+    }
+    else
+      _errors++;
+  }
+}
+
+void IRAM_ATTR ThermostatDHT::onEdge(void *self)
+{
+  ThermostatDHT *dht = (ThermostatDHT *)self;
+  uint8_t n = dht->_count;
+  if (n >= DHT_EDGES)
+    return;
+  dht->_edges[n] = (micros() & ~1u) | (digitalRead(dht->_pin) == HIGH);
+  dht->_count = n + 1;
+}
+
+// Decodes a captured edge trace. Every data bit is a ~50 us low followed by
+// a high whose width carries the value, so the last 40 high pulses of the
+// trace are the frame regardless of how much of the preamble was captured.
+bool ThermostatDHT::decode(const uint32_t *edges, uint8_t count, uint8_t type, float &temperature, float &humidity)
+{
+  uint8_t data[5] = {0};
+  int8_t bit = 39;
+  for (int16_t i = count - 1; i > 0 && bit >= 0; i--)
+  {
+    if ((edges[i] & 1) || !(edges[i - 1] & 1))
+      continue; // not the falling edge that closes a high pulse
+    if ((edges[i] & ~1u) - (edges[i - 1] & ~1u) > DHT_BIT_THRESHOLD)
+      data[bit / 8] |= 0x80 >> (bit % 8);
+    bit--;
+  }
+  if (bit >= 0 || (uint8_t)(data[0] + data[1] + data[2] + data[3]) != data[4])
+    return false;
+
+  if (type == DHT11)
+  {
+    humidity = data[0] + data[1] * 0.1;
+    temperature = data[2] + (data[3] & 0x0f) * 0.1;
+    if (data[3] & 0x80)
+      temperature = -temperature;
+  }
+  else
+  {
+    humidity = ((data[0] << 8) | data[1]) * 0.1;
+    temperature = (((data[2] & 0x7f) << 8) | data[3]) * 0.1;
+    if (data[2] & 0x80)
+      temperature = -temperature;
+  }
+  return true;
+}
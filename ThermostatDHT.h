@@ -0,0 +1,48 @@
+#ifndef ThermostatDHT_H
+#define ThermostatDHT_H
+
+#include "Arduino.h"
+
+#ifndef DHT11
+#define DHT11 11
+#endif
+#ifndef DHT22
+#define DHT22 22
+#endif
+
+#define DHT_EDGES 88          // release + response + 40 bits + tail, with margin
+#define DHT_CAPTURE_TIMEOUT 8 // ms, a full frame takes about 5 ms
+#define DHT_BIT_THRESHOLD 48  // us, high pulses longer than this are ones
+
+// Non-blocking DHT11/DHT22 driver. start() pulls the line low, loop()
+// releases it and lets a pin-change interrupt timestamp every edge of the
+// answer; the frame is decoded later from loop(), never with interrupts off.
+class ThermostatDHT
+{
+public:
+  ThermostatDHT(uint8_t pin, uint8_t type = DHT11);
+  void begin();
+  bool start();
+  void loop();
+  bool isBusy();
+  bool available();
+  float readTemperature();
+  float readHumidity();
+  uint32_t getFrames();
+  uint32_t getErrors();
+  static bool decode(const uint32_t *edges, uint8_t count, uint8_t type, float &temperature, float &humidity);
+
+private:
+  enum Phase : uint8_t { IDLE, START, CAPTURE };
+  uint8_t _pin, _type;
+  volatile Phase _phase = IDLE;
+  bool _available = false;
+  unsigned long _phaseMillis = 0;
+  float _temperature = NAN, _humidity = NAN;
+  uint32_t _frames = 0, _errors = 0;
+  volatile uint8_t _count = 0;
+  volatile uint32_t _edges[DHT_EDGES]; // micros() with the line level in bit 0
+  static void onEdge(void *self);
+};
+
+#endif
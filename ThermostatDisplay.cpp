@@ -1,4 +1,5 @@
 #include "ThermostatDisplay.h"
+#include "ThermostatGlyphs.h"
 
 ThermostatDisplay::ThermostatDisplay(const uint8_t pin_sda, const uint8_t pin_scl)
 {
@@ -10,109 +11,283 @@ ThermostatDisplay::ThermostatDisplay(const uint8_t pin_sda, const uint8_t pin_sc
 void ThermostatDisplay::setTemperature(float temp) { _temperature = temp; }
 void ThermostatDisplay::setHumidity(float humidity) { _humidity = humidity; }
 void ThermostatDisplay::setPoint(int point) { _point = point; }
-void ThermostatDisplay::setWifi(String wifi) { _wifi = wifi; }
+void ThermostatDisplay::setWifi(const char *wifi) { strlcpy(_wifi, wifi, sizeof(_wifi)); }
 void ThermostatDisplay::setThermState(ThermostatState st) { _state = st; }
+bool ThermostatDisplay::isPresent() { return _present; }
+uint32_t ThermostatDisplay::getBytesSent() { return _bytesSent; }
+uint32_t ThermostatDisplay::getFramesSent() { return _framesSent; }
+uint32_t ThermostatDisplay::getFramesSkipped() { return _framesSkipped; }
+uint32_t ThermostatDisplay::getMaxTransferMicros() { return _maxTransferMicros; }
 
+// average time of a transfer() call that had something to send
+uint32_t ThermostatDisplay::getTransferMicros() { return _transfers > 0 ? _transferMicros / _transfers : 0; }
+
+// frames fully on the panel per second since the previous call
+float ThermostatDisplay::getFramesPerSecond()
+{
+  unsigned long now = millis();
+  float fps = now > _fpsSince ? _fpsFrames * 1000.0 / (now - _fpsSince) : 0;
+  _fpsFrames = 0;
+  _fpsSince = now;
+  return fps;
+}
+
+// Only the transition matters: a blank frame is committed once and then
+// nothing is composed or sent while the display stays off.
 void ThermostatDisplay::setEnable(bool enable)
 {
+  if (enable == _enable || !_present)
+    return;
   _enable = enable;
   if (!_enable)
   {
     display->clearDisplay();
-    display->setTextColor(SSD1306_WHITE);
-    display->setCursor(0, 0);
-    display->display();
+    commit();
   }
 }
 
-void ThermostatDisplay::begin()
+// A panel that does not answer on the bus, or a buffer that cannot be
+// allocated, leaves the display absent: every call becomes a no-op and the
+// thermostat keeps running headless.
+bool ThermostatDisplay::begin()
 {
   Wire.begin(_pin_sda, _pin_scl);
-  if (!display->begin(SSD1306_SWITCHCAPVCC, 0x3C))
+  Wire.beginTransmission(OLED_ADDRESS);
+  if (Wire.endTransmission() != 0 || !display->begin(SSD1306_SWITCHCAPVCC, OLED_ADDRESS))
   {
-    Serial.println(F("SSD1306 allocation failed"));
-    for (;;)
-      ;
+    _present = false;
+    return false;
   }
+  _present = true;
   display->clearDisplay();
+  display->display();
+  memcpy(_front, display->getBuffer(), sizeof(_front));
+  memset(_dirtyFrom, 0xFF, sizeof(_dirtyFrom));
+  memset(_dirtyTo, 0, sizeof(_dirtyTo));
+  _windowPage = _windowX = -1;
+  _fpsSince = millis();
+  return true;
+}
+
+bool ThermostatDisplay::isDirty()
+{
+  for (uint8_t page = 0; page < OLED_PAGES; page++)
+    if (_dirtyFrom[page] <= _dirtyTo[page])
+      return true;
+  return false;
+}
+
+// Copies the columns of each page that differ into the front buffer and
+// widens that page's dirty range to cover them; a frame identical to the
+// front buffer leaves nothing to send.
+void ThermostatDisplay::commit()
+{
+  const uint8_t *buffer = display->getBuffer();
+  bool changed = false;
+  for (uint8_t page = 0; page < OLED_PAGES; page++)
+  {
+    const uint8_t *row = buffer + page * SCREEN_WIDTH;
+    uint8_t *front = _front + page * SCREEN_WIDTH;
+    int16_t x0 = 0, x1 = SCREEN_WIDTH - 1;
+    while (x0 < SCREEN_WIDTH && row[x0] == front[x0])
+      x0++;
+    if (x0 == SCREEN_WIDTH)
+      continue;
+    while (row[x1] == front[x1])
+      x1--;
+    memcpy(front + x0, row + x0, x1 - x0 + 1);
+    if (_dirtyFrom[page] > _dirtyTo[page])
+    {
+      _dirtyFrom[page] = x0;
+      _dirtyTo[page] = x1;
+    }
+    else
+    {
+      _dirtyFrom[page] = min(_dirtyFrom[page], (uint8_t)x0);
+      _dirtyTo[page] = max(_dirtyTo[page], (uint8_t)x1);
+    }
+    changed = true;
+  }
+  if (!changed)
+    _framesSkipped++;
+}
+
+// Sends the next chunk of the first dirty page, if any.
+void ThermostatDisplay::transfer()
+{
+  if (!_present)
+    return;
+  for (uint8_t page = 0; page < OLED_PAGES; page++)
+  {
+    if (_dirtyFrom[page] > _dirtyTo[page])
+      continue;
+    uint32_t start = micros();
+    sendChunk(page);
+    uint32_t elapsed = micros() - start;
+    _transfers++;
+    _transferMicros += elapsed;
+    _maxTransferMicros = max(_maxTransferMicros, elapsed);
+    if (!isDirty())
+    {
+      _framesSent++;
+      _fpsFrames++;
+    }
+    return;
+  }
+}
+
+void ThermostatDisplay::sendChunk(uint8_t page)
+{
+  uint8_t x = _dirtyFrom[page], x1 = _dirtyTo[page];
+  // the panel keeps incrementing the column inside its window, so a range
+  // continued from the previous chunk needs no new address
+  if (_windowPage != page || _windowX != x)
+  {
+    display->ssd1306_command(SSD1306_PAGEADDR);
+    display->ssd1306_command(page);
+    display->ssd1306_command(page);
+    display->ssd1306_command(SSD1306_COLUMNADDR);
+    display->ssd1306_command(x);
+    display->ssd1306_command(SCREEN_WIDTH - 1);
+    _bytesSent += 12; // command bytes, each with its own control byte
+  }
+
+  const uint8_t *row = _front + page * SCREEN_WIDTH;
+  Wire.beginTransmission(OLED_ADDRESS);
+  Wire.write((uint8_t)0x40);
+  uint8_t n = 1;
+  for (; n < OLED_I2C_CHUNK && x <= x1; n++, x++)
+    Wire.write(row[x]);
+  Wire.endTransmission();
+  _bytesSent += n;
+
+  _windowPage = page;
+  _windowX = x < SCREEN_WIDTH ? x : -1;
+  if (x > x1)
+  {
+    _dirtyFrom[page] = 0xFF;
+    _dirtyTo[page] = 0;
+  }
+  else
+    _dirtyFrom[page] = x;
 }
 
 void ThermostatDisplay::showLoaderScreen()
 {
+  if (!_present)
+    return;
   display->clearDisplay();
 
   display->setCursor(0, 0);
   display->setTextColor(SSD1306_WHITE);
-  display->setTextSize(1.25);
+  display->setTextSize(1);
   display->println("Conectado a");
   display->println(_wifi);
 
-  display->display();
+  commit();
 }
 
 void ThermostatDisplay::showApModeScreen()
 {
-  if (!_enable)
+  if (!_enable || !_present)
     return;
   display->clearDisplay();
 
   display->setCursor(0, 0);
   display->setTextColor(SSD1306_WHITE);
-  display->setTextSize(0.75);
+  display->setTextSize(1);
   display->println("Conectese a Wi-Fi:");
   display->println(_wifi);
   display->println("para configurar este dispositivo!");
 
-  display->display();
+  commit();
 }
 
+// Numbers are formatted on the stack and drawn from the pre-rasterized
+// glyphs, every field on a page boundary: the point at size 3 on pages
+// 1-3, readings and the mode tag at size 1 on pages 2 and 3.
 void ThermostatDisplay::loop()
 {
-  if (!_enable)
+  if (!_enable || !_present)
     return;
   display->clearDisplay();
   display->setCursor(0, 0);
   display->setTextColor(SSD1306_WHITE);
-
-  display->setTextSize(0.5);
+  display->setTextSize(1);
   display->print("WiFi:");
   display->println(_wifi);
 
-  display->setCursor(0, 12);
-  display->setTextSize(3);
-  String ty = "";
+  char number[8];
+  uint8_t x;
   switch (_state)
   {
   case COOL:
-    ty = " CL ";
   case HEAT:
-    display->print(String(_point, 0));
-    display->setTextSize(1.25);
-    display->print((char)247);
-    display->println("C");
-    display->setCursor(38, 24);
-    display->setTextSize(0.5);
-    display->setTextColor(SSD1306_BLACK, SSD1306_WHITE);
-    display->println(ty.isEmpty() ? " HT " : ty);
+    formatNumber(number, sizeof(number), _point, 0);
+    x = drawLarge(0, 1, number);
+    drawSmall(x, 1, "\xF8" "C");
+    drawSmall(38, 3, _state == COOL ? " CL " : " HT ", true);
     break;
   case FAN:
-    display->print("FAN");
+    drawLarge(0, 1, "FAN");
     break;
   default:
     break;
   }
 
-  display->setTextColor(SSD1306_WHITE);
-  int x = 70;
-  display->setTextSize(1);
-  display->setCursor(x, 13);
-  display->print(String(_temperature, 1));
-  display->print((char)247);
-  display->println("C");
+  formatNumber(number, sizeof(number), _temperature, 1);
+  x = drawSmall(70, 2, number);
+  drawSmall(x, 2, "\xF8" "C");
 
-  display->setCursor(x, 24);
-  display->print(String(_humidity, 0));
-  display->print("%");
+  formatNumber(number, sizeof(number), _humidity, 0);
+  x = drawSmall(70, 3, number);
+  drawSmall(x, 3, "%");
 
-  display->display();
+  commit();
+}
+
+// Blits size 1 glyphs straight into the frame buffer, one byte per column;
+// returns the x after the text. Characters without a glyph are skipped.
+uint8_t ThermostatDisplay::drawSmall(uint8_t x, uint8_t page, const char *text, bool invert)
+{
+  uint8_t *row = display->getBuffer() + page * SCREEN_WIDTH;
+  for (; *text != '\0' && x + GLYPH_SMALL_ADVANCE <= SCREEN_WIDTH; text++)
+  {
+    const char *found = strchr(GLYPH_SMALL_CHARS, *text);
+    if (found == NULL)
+      continue;
+    const uint8_t *glyph = GLYPH_SMALL[found - GLYPH_SMALL_CHARS];
+    for (uint8_t i = 0; i < GLYPH_SMALL_WIDTH; i++)
+    {
+      uint8_t column = pgm_read_byte(glyph + i);
+      row[x++] = invert ? ~column : column;
+    }
+    row[x++] = invert ? 0xFF : 0x00;
+  }
+  return x;
+}
+
+// Same for the size 3 glyphs, which span GLYPH_LARGE_PAGES pages.
+uint8_t ThermostatDisplay::drawLarge(uint8_t x, uint8_t page, const char *text)
+{
+  uint8_t *buffer = display->getBuffer();
+  for (; *text != '\0' && x + GLYPH_LARGE_WIDTH <= SCREEN_WIDTH && page + GLYPH_LARGE_PAGES <= OLED_PAGES; text++)
+  {
+    const char *found = strchr(GLYPH_LARGE_CHARS, *text);
+    if (found == NULL)
+      continue;
+    for (uint8_t p = 0; p < GLYPH_LARGE_PAGES; p++)
+      memcpy_P(buffer + (page + p) * SCREEN_WIDTH + x, GLYPH_LARGE[found - GLYPH_LARGE_CHARS][p], GLYPH_LARGE_WIDTH);
+    x += GLYPH_LARGE_ADVANCE;
+  }
+  return min(x, (uint8_t)SCREEN_WIDTH);
+}
+
+// Heap-free replacement for String(value, decimals); no reading shows "--".
+void ThermostatDisplay::formatNumber(char *buffer, size_t size, float value, uint8_t decimals)
+{
+  if (isnan(value))
+    snprintf(buffer, size, "--");
+  else
+    snprintf(buffer, size, "%.*f", decimals, value);
 }
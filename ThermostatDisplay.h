@@ -11,29 +11,57 @@
 #define SCREEN_WIDTH 128 // OLED display width, in pixels
 #define SCREEN_HEIGHT 32 // OLED display height, in pixels
 #define OLED_RESET -1    // Reset pin # (or -1 if sharing Arduino reset pin)
+#define OLED_ADDRESS 0x3C
+#define OLED_PAGES (SCREEN_HEIGHT / 8)
+#define OLED_I2C_CHUNK 32 // I2C bytes per transmission, control byte included
 
+// Frames are composed into the Adafruit buffer (back) and committed into
+// the front buffer, which tracks a dirty column range per page. transfer()
+// sends at most one I2C chunk of the front buffer per call, so a frame is
+// spread over several loop passes and a current panel costs nothing.
 class ThermostatDisplay
 {
 public:
   ThermostatDisplay(const uint8_t pin_sda = 0, const uint8_t pin_scl = 0);
-  void begin();
+  bool begin();
+  bool isPresent();
   void loop();
+  void transfer();
   void setTemperature(float temp);
   void setHumidity(float humidity);
   void setPoint(int point);
-  void setWifi(String wifi);
+  void setWifi(const char *wifi);
   void setThermState(ThermostatState st);
   void showApModeScreen();
   void showLoaderScreen();
   void setEnable(bool enable);
+  uint32_t getBytesSent();
+  uint32_t getFramesSent();
+  uint32_t getFramesSkipped();
+  uint32_t getTransferMicros();
+  uint32_t getMaxTransferMicros();
+  float getFramesPerSecond();
   Adafruit_SSD1306 *display;
 
 private:
   uint8_t _pin_sda, _pin_scl;
   float _temperature, _humidity, _point;
-  String _wifi;
+  char _wifi[33] = ""; // SSID, 32 chars at most
   ThermostatState _state;
-  bool _enable = true;
+  bool _enable = true, _present = false;
+  uint8_t _front[SCREEN_WIDTH * OLED_PAGES]; // the panel once the dirty ranges are sent
+  uint8_t _dirtyFrom[OLED_PAGES], _dirtyTo[OLED_PAGES];
+  int16_t _windowPage = -1, _windowX = -1; // where the panel writes next, -1 unknown
+  uint32_t _bytesSent = 0, _framesSent = 0, _framesSkipped = 0;
+  uint32_t _transfers = 0, _transferMicros = 0, _maxTransferMicros = 0;
+  uint32_t _fpsFrames = 0;
+  unsigned long _fpsSince = 0;
+  void commit();
+  bool isDirty();
+  void sendChunk(uint8_t page);
+  uint8_t drawSmall(uint8_t x, uint8_t page, const char *text, bool invert = false);
+  uint8_t drawLarge(uint8_t x, uint8_t page, const char *text);
+  static void formatNumber(char *buffer, size_t size, float value, uint8_t decimals);
 };
 
 static const unsigned char PROGMEM IMG_FIRE[] = {0x08, 0x00, 0x08, 0x00, 0x14, 0x00, 0x24, 0x00, 0x40, 0x00, 0x46, 0x00, 0x49, 0x00, 0x41, 0x00, 0x22, 0x00, 0x1c, 0x00};
@@ -0,0 +1,148 @@
+#ifndef ThermostatGroup_H
+#define ThermostatGroup_H
+
+#include "Arduino.h"
+#include "Thermostat.h"
+
+#define ZONE_STATE 0x01
+#define ZONE_POINT 0x02
+#define ZONE_TEMPERATURE 0x04
+#define ZONE_OUTPUTS 0x08
+
+#define INVALID_ZONE 0xFFFF
+
+typedef std::function<void(uint16_t zone, uint8_t changes)> ZoneCallback;
+
+// Several zones run by one controller, up to INVALID_ZONE - 1 of them.
+// Zone inputs live in parallel arrays so update() walks each field
+// contiguously: demand for every zone is worked out in one branch-free
+// pass, then ThermostatEngine's cycle state machine steps each zone and
+// only zones whose mode, point, reading or relays changed are reported.
+// Settings (hysteresis, minimum on/off, fan overrun) are shared by the
+// group and behave like the single-zone Thermostat.
+template <size_t N>
+class ThermostatGroup
+{
+  static_assert(N > 0 && N < INVALID_ZONE, "zones are numbered with uint16_t");
+
+public:
+  uint16_t addZone(uint8_t pinFan, uint8_t pinCool, uint8_t pinHeat)
+  {
+    if (_count >= N)
+      return INVALID_ZONE;
+    uint16_t zone = _count++;
+    _pins[0][zone] = pinFan;
+    _pins[1][zone] = pinCool;
+    _pins[2][zone] = pinHeat;
+    _state[zone] = OFF;
+    _point[zone] = NAN;
+    _temperature[zone] = NAN;
+    _cycle[zone] = ThermostatCycle();
+    _outputs[zone] = 0;
+    _changes[zone] = 0;
+    return zone;
+  }
+
+  void begin()
+  {
+    for (uint8_t p = 0; p < 3; p++)
+      for (uint16_t i = 0; i < _count; i++)
+      {
+        pinMode(_pins[p][i], OUTPUT);
+        digitalWrite(_pins[p][i], HIGH);
+      }
+  }
+
+  void setHysteresis(float band) { _timing.hysteresis = band; }
+  void setMinOnTime(unsigned long ms) { _timing.minOnTime = ms; }
+  void setMinOffTime(unsigned long ms) { _timing.minOffTime = ms; }
+  void setFanOverrun(unsigned long ms) { _timing.fanOverrun = ms; }
+  void setOnZoneChange(ZoneCallback func) { _onZoneChange = func; }
+
+  void setState(uint16_t zone, ThermostatState state)
+  {
+    if (zone >= _count || _state[zone] == state)
+      return;
+    _state[zone] = state;
+    _changes[zone] |= ZONE_STATE;
+  }
+
+  void setPoint(uint16_t zone, float point)
+  {
+    if (zone >= _count || !ThermostatEngine::isChange(_point[zone], point))
+      return;
+    _point[zone] = point;
+    _changes[zone] |= ZONE_POINT;
+  }
+
+  void setTemperature(uint16_t zone, float temperature)
+  {
+    if (zone >= _count || !ThermostatEngine::isChange(_temperature[zone], temperature))
+      return;
+    _temperature[zone] = temperature;
+    _changes[zone] |= ZONE_TEMPERATURE;
+  }
+
+  void update() { update(millis()); }
+
+  void update(unsigned long now)
+  {
+    for (uint16_t i = 0; i < _count; i++)
+      _demand[i] = ThermostatEngine::demand(_state[i], _cycle[i].phase == ThermostatCycle::RUNNING, _point[i], _temperature[i], _timing.hysteresis);
+
+    for (uint16_t i = 0; i < _count; i++)
+    {
+      uint8_t outputs = ThermostatEngine::step(_cycle[i], _state[i], _demand[i], now, _timing);
+      if (outputs != _outputs[i])
+      {
+        write(i, outputs);
+        _outputs[i] = outputs;
+        _changes[i] |= ZONE_OUTPUTS;
+      }
+    }
+
+    for (uint16_t i = 0; i < _count; i++)
+    {
+      if (_changes[i] == 0)
+        continue;
+      uint8_t changes = _changes[i];
+      _changes[i] = 0;
+      if (_onZoneChange != NULL)
+        _onZoneChange(i, changes);
+    }
+  }
+
+  uint16_t getCount() { return _count; }
+  ThermostatState getState(uint16_t zone) { return _state[zone]; }
+  float getPoint(uint16_t zone) { return _point[zone]; }
+  float getTemperature(uint16_t zone) { return _temperature[zone]; }
+  uint8_t getOutputs(uint16_t zone) { return _outputs[zone]; }
+  uint32_t getCycles(uint16_t zone) { return _cycle[zone].cycles; }
+
+private:
+  uint16_t _count = 0;
+  ThermostatTiming _timing;
+  ZoneCallback _onZoneChange;
+
+  uint8_t _pins[3][N];
+  ThermostatState _state[N];
+  float _point[N];
+  float _temperature[N];
+  bool _demand[N];
+  ThermostatCycle _cycle[N];
+  uint8_t _outputs[N];
+  uint8_t _changes[N];
+
+  // active low; release first so heat and cool never overlap
+  void write(uint16_t zone, uint8_t outputs)
+  {
+    for (uint8_t p = 0; p < 3; p++)
+      if (!(outputs & (1 << p)))
+        digitalWrite(_pins[p][zone], HIGH);
+    for (uint8_t p = 0; p < 3; p++)
+      if (outputs & (1 << p))
+        digitalWrite(_pins[p][zone], LOW);
+  }
+};
+
+#endif
@@ -1,5 +1,17 @@
 #include "ThermostatIRCtrls.h"
 
+static const uint8_t kMirageTemps[] = { 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32 };
+static const char kMirageModes[] = "0123456789ABCDEF";
+static const ThermostatIRCtrls::TCSpeed kMirageSpeeds[] = {
+  ThermostatIRCtrls::AUTO1, ThermostatIRCtrls::SPEED3, ThermostatIRCtrls::SPEED1, ThermostatIRCtrls::SPEED2,
+  ThermostatIRCtrls::AUTO1, ThermostatIRCtrls::SPEED3, ThermostatIRCtrls::SPEED1, ThermostatIRCtrls::SPEED2
+};
+
+// New AC remotes are added here as tables, not code.
+static const ThermostatIRCtrls::Protocol kProtocols[] = {
+  { decode_type_t::MIRAGE, 1, 0x6C, sizeof(kMirageTemps), kMirageTemps, 4, kMirageModes, kMirageSpeeds, 5 },
+};
+
 ThermostatIRCtrls::ThermostatIRCtrls(const uint8_t recvpin){
   _irrecv = new IRrecv(recvpin, _kCaptureBufferSize, _kTimeout, true);
 }
@@ -13,6 +25,7 @@ void ThermostatIRCtrls::setOnModeChange(std::function<TCMode(TCMode, TCMode)> fu
 void ThermostatIRCtrls::setOnTabChange(std::function<TCTab(TCTab, TCTab)> func) { _onTabChange = func; }
 void ThermostatIRCtrls::setOnSpeedChange(std::function<TCSpeed(TCSpeed, TCSpeed)> func) { _onSpeedChange = func; }
 void ThermostatIRCtrls::setOnChange(std::function<void(TCSpeed, TCTab, TCMode, int)> func) { _onChange = func; }
+void ThermostatIRCtrls::setOnFrame(std::function<void(const decode_results*)> func) { _onFrame = func; }
 
 void ThermostatIRCtrls::begin(ThermostatIRCtrls::TCMode mode, ThermostatIRCtrls::TCSpeed speed, ThermostatIRCtrls::TCTab tab, int temp) {
   _mode=mode;
@@ -62,66 +75,38 @@ String ThermostatIRCtrls::stateToString(const decode_results* const results) {
   return output;
 }
 
-ThermostatIRCtrls::TCMode ThermostatIRCtrls::getMode(const decode_results* const results) {
-  String state = uint64ToString(results->state[4], 16);
-  return (ThermostatIRCtrls::TCMode) state.c_str()[0];
+const ThermostatIRCtrls::Protocol* ThermostatIRCtrls::getProtocol(decode_type_t type) {
+  for (const Protocol& protocol : kProtocols)
+    if (protocol.type == type) return &protocol;
+  return NULL;
 }
 
-ThermostatIRCtrls::TCSpeed ThermostatIRCtrls::getSpeed(const decode_results* const results) {
-  String state = uint64ToString(results->state[4], 16);
-  switch(state.c_str()[1]){
-    case '0':
-    case '4': return AUTO1;
-    
-    case '6':
-    case '2': return SPEED1;
-    
-    case '7':
-    case '3': return SPEED2;
-    
-    case '5':
-    case '1': return SPEED3;
-  }  
+ThermostatIRCtrls::TCMode ThermostatIRCtrls::getMode(const Protocol* const protocol, const decode_results* const results) {
+  return (ThermostatIRCtrls::TCMode) protocol->modes[results->state[protocol->modeByte] >> 4];
 }
 
-ThermostatIRCtrls::TCTab ThermostatIRCtrls::getTab(const decode_results* const results) {
-  return (ThermostatIRCtrls::TCTab) results->state[5];
+ThermostatIRCtrls::TCSpeed ThermostatIRCtrls::getSpeed(const Protocol* const protocol, const decode_results* const results) {
+  return protocol->speeds[results->state[protocol->modeByte] & 0x07];
 }
 
-int ThermostatIRCtrls::getTemp(const decode_results* const results) {
-  switch(results->state[1]) {
-    case 0x6C: return 16;
-    case 0x6D: return 17;
-    case 0x6E: return 18;
-    case 0x6F: return 19;
-    case 0x70: return 20;
-    case 0x71: return 21;
-    case 0x72: return 22;
-    case 0x73: return 23;
-    case 0x74: return 24;
-    case 0x75: return 25;
-    case 0x76: return 26;
-    case 0x77: return 27;
-    case 0x78: return 28;
-    case 0x79: return 29;
-    case 0x7A: return 30;
-    case 0x7B: return 31;
-    case 0x7C: return 32;
-  }
-  return 0;
+ThermostatIRCtrls::TCTab ThermostatIRCtrls::getTab(const Protocol* const protocol, const decode_results* const results) {
+  return (ThermostatIRCtrls::TCTab) results->state[protocol->tabByte];
 }
 
-String ThermostatIRCtrls::getIRProtocol(const decode_results* const results){
-  return typeToString(results->decode_type, results->repeat);
+int ThermostatIRCtrls::getTemp(const Protocol* const protocol, const decode_results* const results) {
+  uint8_t index = results->state[protocol->tempByte] - protocol->tempBase;
+  return index < protocol->tempCount ? protocol->temps[index] : 0;
 }
 
 void ThermostatIRCtrls::loop(){
   if (_irrecv->decode(&_results)) {
-    if(getIRProtocol(&_results) == "MIRAGE") {
-      TCSpeed _nextSpeed = getSpeed(&_results);
-      int _nextTemp = getTemp(&_results);
-      TCMode _nextMode = getMode(&_results);
-      TCTab _nextTab = getTab(&_results);
+    if (_onFrame != NULL) _onFrame(&_results);
+    const Protocol* protocol = getProtocol(_results.decode_type);
+    if(protocol != NULL) {
+      TCSpeed _nextSpeed = getSpeed(protocol, &_results);
+      int _nextTemp = getTemp(protocol, &_results);
+      TCMode _nextMode = getMode(protocol, &_results);
+      TCTab _nextTab = getTab(protocol, &_results);
       
       if ( _onChange != NULL) _onChange(_nextSpeed, _nextTab, _nextMode, _nextTemp);   
       if ( _onSpeedChange != NULL) _nextSpeed = _onSpeedChange(_speed, _nextSpeed);      
@@ -32,13 +32,26 @@ class ThermostatIRCtrls {
     void setOnTabChange(std::function<TCTab(TCTab, TCTab)> func);
     void setOnSpeedChange(std::function<TCSpeed(TCSpeed, TCSpeed)> func);
     void setOnChange(std::function<void(TCSpeed, TCTab, TCMode, int)> func);
+    void setOnFrame(std::function<void(const decode_results*)> func);
+
+    // Where a remote protocol keeps each setting in decode_results::state,
+    // and the lookup tables that turn the raw bytes into settings.
+    struct Protocol {
+      decode_type_t type;
+      uint8_t tempByte, tempBase, tempCount;
+      const uint8_t* temps;    // indexed by state[tempByte] - tempBase
+      uint8_t modeByte;
+      const char* modes;       // indexed by the high nibble of state[modeByte]
+      const TCSpeed* speeds;   // indexed by the low 3 bits of state[modeByte]
+      uint8_t tabByte;
+    };
 
   protected:
-    String getIRProtocol(const decode_results* const results);
-    TCMode getMode(const decode_results* const results);
-    TCSpeed getSpeed(const decode_results* const results);
-    TCTab getTab(const decode_results* const results);
-    int getTemp(const decode_results* const results);
+    static const Protocol* getProtocol(decode_type_t type);
+    TCMode getMode(const Protocol* const protocol, const decode_results* const results);
+    TCSpeed getSpeed(const Protocol* const protocol, const decode_results* const results);
+    TCTab getTab(const Protocol* const protocol, const decode_results* const results);
+    int getTemp(const Protocol* const protocol, const decode_results* const results);
     String stateToString(const decode_results* const results);
     
   private:
@@ -55,6 +68,7 @@ class ThermostatIRCtrls {
     std::function<TCTab(TCTab, TCTab)> _onTabChange;
     std::function<TCSpeed(TCSpeed, TCSpeed)> _onSpeedChange;
     std::function<void(TCSpeed, TCTab, TCMode, int)> _onChange;
+    std::function<void(const decode_results*)> _onFrame;
 };
 
 inline const String toString(ThermostatIRCtrls::TCMode v) {
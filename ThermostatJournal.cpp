@@ -0,0 +1,161 @@
+#include "ThermostatJournal.h"
+
+extern "C" uint32_t _FS_start;
+extern "C" uint32_t _FS_end;
+
+ThermostatJournal::ThermostatJournal(uint16_t size, uint8_t sectors, unsigned long delay)
+{
+  _size = size;
+  _sectors = sectors;
+  _delay = delay;
+  _slot = (sizeof(Header) + size + 3) & ~3;
+  _record = new uint32_t[_slot / 4];
+  _pending = new uint8_t[size];
+}
+
+bool ThermostatJournal::isReady() { return _ready; }
+uint32_t ThermostatJournal::getErases() { return _erases; }
+uint32_t ThermostatJournal::getCommits() { return _commits; }
+uint32_t ThermostatJournal::getCoalesced() { return _coalesced; }
+uint32_t ThermostatJournal::getCommitMicros() { return _commitMicros; }
+uint32_t ThermostatJournal::getMaxCommitMicros() { return _maxCommitMicros; }
+
+uint32_t ThermostatJournal::address(uint8_t sector, uint16_t offset)
+{
+  return (_firstSector + sector) * SPI_FLASH_SEC_SIZE + offset;
+}
+
+// Finds the newest valid record. Every written slot is CRC-checked, header
+// and payload, before its sequence is trusted, so a torn write (even a header whose sequence
+// is still erased) is skipped wherever it sits, and the newest record may
+// be in an earlier sector than the last written slot.
+bool ThermostatJournal::begin()
+{
+  uint32_t start = (uintptr_t)&_FS_start - 0x40200000, end = (uintptr_t)&_FS_end - 0x40200000;
+  if (end <= start || (end - start) / SPI_FLASH_SEC_SIZE < _sectors)
+    return false;
+  _firstSector = start / SPI_FLASH_SEC_SIZE;
+  _ready = true;
+
+  uint32_t newest = 0;
+  uint16_t newestOffset = 0, newestUsed = 0;
+  for (uint8_t sector = 0; sector < _sectors; sector++)
+  {
+    uint16_t used = 0;
+    bool newer = false;
+    for (uint16_t offset = 0; offset + _slot <= SPI_FLASH_SEC_SIZE; offset += _slot)
+    {
+      bool valid = load(sector, offset);
+      Header *header = (Header *)_record;
+      if (header->magic == 0xFFFFFFFF)
+        break;
+      used = offset + _slot;
+      if (valid && header->sequence != 0xFFFFFFFF && header->sequence > newest)
+      {
+        newest = header->sequence;
+        newestOffset = offset;
+        _sector = sector;
+        newer = true;
+      }
+    }
+    if (newer)
+      newestUsed = used;
+  }
+
+  if (newest == 0)
+  {
+    // no journal yet: the first commit erases and starts sector 0
+    _sector = _sectors - 1;
+    _offset = SPI_FLASH_SEC_SIZE;
+    return true;
+  }
+  // appends go after the last written slot of that sector, torn or not; a
+  // torn slot at the start of the next sector is erased with it
+  _offset = newestUsed;
+  _valid = load(_sector, newestOffset);
+  _sequence = newest;
+  return true;
+}
+
+bool ThermostatJournal::load(uint8_t sector, uint16_t offset)
+{
+  ESP.flashRead(address(sector, offset), _record, _slot);
+  Header *header = (Header *)_record;
+  const uint8_t *payload = (const uint8_t *)(header + 1);
+  return header->magic == JOURNAL_MAGIC && header->size == _size && header->crc == checksum(header, payload);
+}
+
+bool ThermostatJournal::read(void *buffer)
+{
+  if (!_valid)
+    return false;
+  memcpy(buffer, (const uint8_t *)_record + sizeof(Header), _size);
+  return true;
+}
+
+void ThermostatJournal::write(const void *buffer)
+{
+  const uint8_t *committed = (const uint8_t *)_record + sizeof(Header);
+  if (!_dirty && _valid && memcmp(committed, buffer, _size) == 0)
+    return;
+  if (_dirty)
+    _coalesced++;
+  memcpy(_pending, buffer, _size);
+  _dirty = true;
+  _changed = millis();
+}
+
+void ThermostatJournal::loop()
+{
+  if (_dirty && millis() - _changed >= _delay)
+    flush();
+}
+
+bool ThermostatJournal::flush()
+{
+  if (!_ready || !_dirty)
+    return false;
+  uint32_t start = micros();
+  if (_offset + _slot > SPI_FLASH_SEC_SIZE)
+  {
+    _sector = (_sector + 1) % _sectors;
+    _offset = 0;
+    ESP.flashEraseSector(_firstSector + _sector);
+    _erases++;
+  }
+
+  memset(_record, 0xFF, _slot);
+  Header *header = (Header *)_record;
+  header->magic = JOURNAL_MAGIC;
+  header->sequence = ++_sequence;
+  header->size = _size;
+  header->crc = checksum(header, _pending);
+  memcpy(header + 1, _pending, _size);
+  bool ok = ESP.flashWrite(address(_sector, _offset), _record, _slot);
+  _offset += _slot;
+  _dirty = false;
+  _valid = ok;
+
+  _commits++;
+  _commitMicros = micros() - start;
+  _maxCommitMicros = max(_maxCommitMicros, _commitMicros);
+  return ok;
+}
+
+// the header up to its CRC, then the payload: a flipped sequence or size
+// fails the check as surely as a flipped payload byte
+uint16_t ThermostatJournal::checksum(const Header *header, const uint8_t *payload)
+{
+  return crc16(payload, header->size, crc16((const uint8_t *)header, offsetof(Header, crc)));
+}
+
+uint16_t ThermostatJournal::crc16(const uint8_t *data, uint16_t length, uint16_t crc)
+{
+  while (length--)
+  {
+    crc ^= (uint16_t)*data++ << 8;
+    for (uint8_t i = 0; i < 8; i++)
+      crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
+}
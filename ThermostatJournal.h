@@ -0,0 +1,50 @@
+#ifndef ThermostatJournal_H
+#define ThermostatJournal_H
+
+#include "Arduino.h"
+
+#define JOURNAL_SECTORS 4
+#define JOURNAL_DELAY 5000 // ms without changes before a record is written
+#define JOURNAL_MAGIC 0x4D524854
+
+// Append-only, CRC-checked record journal rotating over the first sectors
+// of the (otherwise unused) filesystem flash area. Writes are coalesced:
+// only the last value of a burst of changes reaches the flash, and a sector
+// is erased only once it is full of records.
+class ThermostatJournal
+{
+public:
+  ThermostatJournal(uint16_t size, uint8_t sectors = JOURNAL_SECTORS, unsigned long delay = JOURNAL_DELAY);
+  bool begin();
+  bool isReady();
+  bool read(void *buffer);
+  void write(const void *buffer);
+  void loop();
+  bool flush();
+  uint32_t getErases();
+  uint32_t getCommits();
+  uint32_t getCoalesced();
+  uint32_t getCommitMicros();
+  uint32_t getMaxCommitMicros();
+
+private:
+  struct Header
+  {
+    uint32_t magic, sequence;
+    uint16_t size, crc;
+  };
+  uint32_t _firstSector = 0, _sequence = 0;
+  uint8_t _sectors, _sector = 0;
+  uint16_t _size, _slot, _offset = 0;
+  uint32_t *_record;
+  uint8_t *_pending;
+  bool _ready = false, _valid = false, _dirty = false;
+  unsigned long _delay, _changed = 0;
+  uint32_t _erases = 0, _commits = 0, _coalesced = 0, _commitMicros = 0, _maxCommitMicros = 0;
+  uint32_t address(uint8_t sector, uint16_t offset);
+  bool load(uint8_t sector, uint16_t offset);
+  static uint16_t checksum(const Header *header, const uint8_t *payload);
+  static uint16_t crc16(const uint8_t *data, uint16_t length, uint16_t crc = 0xFFFF);
+};
+
+#endif
@@ -0,0 +1,101 @@
+#include "ThermostatNetwork.h"
+
+void ThermostatNetwork::setOnChange(std::function<void(uint8_t changes)> func) { _onChange = func; }
+bool ThermostatNetwork::isWifiConnected() { return _wifi; }
+bool ThermostatNetwork::isCloudConnected() { return _cloud; }
+bool ThermostatNetwork::hasSavedNetwork() { return _ssid[0] != '\0'; }
+const char *ThermostatNetwork::getSsid() { return _ssid; }
+int8_t ThermostatNetwork::getRssi() { return _rssi; }
+uint16_t ThermostatNetwork::getAttempts() { return _attempts; }
+uint32_t ThermostatNetwork::getWifiDrops() { return _wifiDrops; }
+uint32_t ThermostatNetwork::getCloudDrops() { return _cloudDrops; }
+
+// Reads the saved network once, then follows the station through events.
+void ThermostatNetwork::begin()
+{
+  strlcpy(_ssid, WiFi.SSID().c_str(), sizeof(_ssid));
+  _wifi = WiFi.status() == WL_CONNECTED;
+  _downAt = millis();
+  _pending = NETWORK_WIFI;
+  _onConnected = WiFi.onStationModeConnected([this](const WiFiEventStationModeConnected &event) {
+    strlcpy(_ssid, event.ssid.c_str(), sizeof(_ssid));
+    _pending |= NETWORK_WIFI;
+  });
+  // a fresh station restarts the cloud backoff from its first step
+  _onGotIP = WiFi.onStationModeGotIP([this](const WiFiEventStationModeGotIP &event) {
+    _wifi = true;
+    _attempts = 0;
+    _pending |= NETWORK_WIFI;
+  });
+  // repeats on every failed association: only the first one is a change
+  _onDisconnected = WiFi.onStationModeDisconnected([this](const WiFiEventStationModeDisconnected &event) {
+    if (!_wifi)
+      return;
+    _wifi = false;
+    _downAt = millis();
+    _wifiDrops++;
+    _pending |= NETWORK_WIFI;
+  });
+}
+
+void ThermostatNetwork::loop()
+{
+  unsigned long now = millis();
+  if (_wifi && now - _rssiAt >= NETWORK_RSSI_INTERVAL)
+  {
+    _rssi = WiFi.RSSI();
+    _rssiAt = now;
+  }
+  if (_pending == 0)
+    return;
+  noInterrupts();
+  uint8_t changes = _pending;
+  _pending = 0;
+  interrupts();
+  if (_onChange != NULL)
+    _onChange(changes);
+}
+
+void ThermostatNetwork::setCloudConnected(bool connected)
+{
+  if (connected == _cloud)
+    return;
+  _cloud = connected;
+  if (connected)
+    _attempts = 0;
+  else
+    _cloudDrops++;
+  _pending |= NETWORK_CLOUD;
+}
+
+// The saved network was erased (WiFiManager::resetSettings()): the cached
+// SSID goes with it, so hasSavedNetwork() answers false from now on.
+void ThermostatNetwork::forget()
+{
+  _ssid[0] = '\0';
+  _pending |= NETWORK_WIFI;
+}
+
+// How long the station has been trying since begin() or its last drop;
+// zero while it is up.
+unsigned long ThermostatNetwork::getDownTime() { return _wifi ? 0 : millis() - _downAt; }
+
+// A lost or refused cloud connection: the next delay is one step longer.
+void ThermostatNetwork::countFailure()
+{
+  if (_attempts < UINT16_MAX)
+    _attempts++;
+}
+
+// Delay before the next cloud attempt: doubles per failure counted since
+// the cloud or the station was last up, to NETWORK_BACKOFF_MAX, then a
+// random point in its upper half. Asking does not count as an attempt.
+unsigned long ThermostatNetwork::getBackoff()
+{
+  uint16_t attempts = _attempts;
+  unsigned long backoff = NETWORK_BACKOFF_MIN;
+  for (uint16_t i = 0; i < attempts && backoff < NETWORK_BACKOFF_MAX; i++)
+    backoff *= 2;
+  backoff = min(backoff, (unsigned long)NETWORK_BACKOFF_MAX);
+  return backoff / 2 + random(backoff / 2 + 1);
+}
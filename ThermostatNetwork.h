@@ -0,0 +1,54 @@
+#ifndef ThermostatNetwork_H
+#define ThermostatNetwork_H
+
+#include "Arduino.h"
+#include <ESP8266WiFi.h>
+
+#define NETWORK_WIFI 0x01
+#define NETWORK_CLOUD 0x02
+
+#define NETWORK_SSID 33             // 32 chars and the terminator
+#define NETWORK_RSSI_INTERVAL 10000 // ms between RSSI samples
+#define NETWORK_BACKOFF_MIN 2000    // first cloud reconnect delay, in ms
+#define NETWORK_BACKOFF_MAX 300000  // cap of the doubling delay, in ms
+
+// Connectivity state kept in fixed buffers. WiFi events and the cloud
+// socket flag transitions; loop() reports them once through the change
+// callback, so nothing polls the WiFi stack or copies a String per pass.
+// Cloud reconnects back off exponentially with jitter, so units that lose
+// the same AP do not come back in lockstep.
+class ThermostatNetwork
+{
+public:
+  void begin();
+  void loop();
+  void setOnChange(std::function<void(uint8_t changes)> func);
+  void setCloudConnected(bool connected);
+  void countFailure();
+  void forget();
+  unsigned long getBackoff();
+  unsigned long getDownTime();
+  bool isWifiConnected();
+  bool isCloudConnected();
+  bool hasSavedNetwork();
+  const char *getSsid();
+  int8_t getRssi();
+  uint16_t getAttempts();
+  uint32_t getWifiDrops();
+  uint32_t getCloudDrops();
+
+private:
+  WiFiEventHandler _onConnected, _onGotIP, _onDisconnected;
+  std::function<void(uint8_t)> _onChange;
+  char _ssid[NETWORK_SSID] = "";
+  volatile uint8_t _pending = 0;
+  volatile bool _wifi = false;
+  volatile unsigned long _downAt = 0; // begin() or the last station drop
+  bool _cloud = false;
+  int8_t _rssi = 0;
+  unsigned long _rssiAt = 0;
+  volatile uint16_t _attempts = 0; // cloud failures since it was last up
+  uint32_t _wifiDrops = 0, _cloudDrops = 0;
+};
+
+#endif
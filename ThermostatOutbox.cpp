@@ -0,0 +1,73 @@
+#include "ThermostatOutbox.h"
+
+ThermostatOutbox::ThermostatOutbox(unsigned long interval, uint8_t burst)
+{
+  _interval = interval;
+  _burst = burst;
+  _tokens = burst;
+}
+
+void ThermostatOutbox::setSender(std::function<bool(Kind)> sender) { _sender = sender; }
+void ThermostatOutbox::setConnected(bool connected) { _connected = connected; }
+uint32_t ThermostatOutbox::getPosted() { return _posted; }
+uint32_t ThermostatOutbox::getSent() { return _sent; }
+uint32_t ThermostatOutbox::getCoalesced() { return _coalesced; }
+uint32_t ThermostatOutbox::getDropped() { return _dropped; }
+uint32_t ThermostatOutbox::getThrottled() { return _throttled; }
+
+void ThermostatOutbox::post(Kind kind)
+{
+  _posted++;
+  if (_pending[kind])
+    _coalesced++;
+  _pending[kind] = true;
+}
+
+// After a reconnect the server only needs the newest state of every kind.
+void ThermostatOutbox::replay()
+{
+  for (uint8_t kind = 0; kind < KINDS; kind++)
+    _pending[kind] = true;
+}
+
+void ThermostatOutbox::loop()
+{
+  unsigned long now = millis();
+  if (_tokens < _burst && now - _refilled >= _interval)
+  {
+    // whole intervals only, the part of one already earned carries over
+    unsigned long earned = (now - _refilled) / _interval;
+    _tokens = min<unsigned long>(_burst, _tokens + earned);
+    _refilled = _tokens < _burst ? _refilled + earned * _interval : now;
+  }
+  else if (_tokens >= _burst)
+    _refilled = now;
+
+  if (!_connected || _sender == NULL)
+    return;
+  for (uint8_t turn = 0; turn < KINDS; turn++)
+  {
+    uint8_t kind = (_next + turn) % KINDS;
+    if (!_pending[kind])
+      continue;
+    if (_tokens == 0)
+    {
+      // counted once per message, however many passes it waits
+      for (uint8_t waiting = 0; waiting < KINDS; waiting++)
+        if (_pending[waiting] && !_waiting[waiting])
+        {
+          _waiting[waiting] = true;
+          _throttled++;
+        }
+      return;
+    }
+    _tokens--;
+    _pending[kind] = _waiting[kind] = false;
+    _next = (kind + 1) % KINDS;
+    // a frame the socket refuses is not retried: the next reconnect replays it
+    if (_sender((Kind)kind))
+      _sent++;
+    else
+      _dropped++;
+  }
+}
@@ -0,0 +1,40 @@
+#ifndef ThermostatOutbox_H
+#define ThermostatOutbox_H
+
+#include "Arduino.h"
+
+#define OUTBOX_INTERVAL 1000 // ms to earn one send token
+#define OUTBOX_BURST 3       // tokens that can be saved up
+
+// Outbound cloud updates, one slot per message kind. Posting only marks a
+// kind as pending and the message is encoded from the current state when
+// it is sent, so a burst of changes collapses into the newest value. Sends
+// are paced by a token bucket and held while the socket is down; pending
+// kinds take turns, so a steady stream of one cannot starve the others.
+class ThermostatOutbox
+{
+public:
+  enum Kind : uint8_t { MODE, SETTING, KINDS };
+
+  ThermostatOutbox(unsigned long interval = OUTBOX_INTERVAL, uint8_t burst = OUTBOX_BURST);
+  void setSender(std::function<bool(Kind)> sender);
+  void setConnected(bool connected);
+  void post(Kind kind);
+  void replay();
+  void loop();
+  uint32_t getPosted();
+  uint32_t getSent();
+  uint32_t getCoalesced();
+  uint32_t getDropped();
+  uint32_t getThrottled();
+
+private:
+  std::function<bool(Kind)> _sender;
+  bool _pending[KINDS] = {false}, _waiting[KINDS] = {false}, _connected = false;
+  uint8_t _next = 0;
+  unsigned long _interval, _refilled = 0;
+  uint8_t _burst, _tokens;
+  uint32_t _posted = 0, _sent = 0, _coalesced = 0, _dropped = 0, _throttled = 0;
+};
+
+#endif
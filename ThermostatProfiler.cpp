@@ -0,0 +1,82 @@
+#include "ThermostatProfiler.h"
+
+uint8_t ThermostatProfiler::getCount() { return _count; }
+const ThermostatProfiler::Phase &ThermostatProfiler::getPhase(uint8_t index) { return _phases[index]; }
+uint32_t ThermostatProfiler::getLoops() { return _loops; }
+uint32_t ThermostatProfiler::getMaxLoopMicros() { return toMicros(_maxLoop); }
+
+uint32_t ThermostatProfiler::toMicros(uint64_t cycles)
+{
+#ifdef ESP8266
+  return cycles / ESP.getCpuFreqMHz();
+#else
+  return cycles;
+#endif
+}
+
+float ThermostatProfiler::getLoopsPerSecond()
+{
+  uint32_t us = toMicros(_elapsed);
+  return us > 0 ? _loops * 1000000.0 / us : 0;
+}
+
+void ThermostatProfiler::record(uint8_t phase, const char *name, uint32_t cycles)
+{
+  if (phase >= PROFILER_PHASES)
+    return;
+  if (phase >= _count)
+  {
+    for (; _count <= phase; _count++)
+      _phases[_count] = {NULL, 0, UINT32_MAX, 0, 0, {0}};
+  }
+  Phase &p = _phases[phase];
+  p.name = name;
+  p.count++;
+  p.total += cycles;
+  if (cycles < p.min)
+    p.min = cycles;
+  if (cycles > p.max)
+    p.max = cycles;
+  p.buckets[min(31 - __builtin_clz(cycles | 1), PROFILER_BUCKETS - 1)]++;
+}
+
+// Called once per loop() pass: loop rate and the longest pass.
+void ThermostatProfiler::mark()
+{
+  uint32_t now = cycles();
+  if (_marked)
+  {
+    uint32_t elapsed = now - _lastMark;
+    _elapsed += elapsed;
+    _loops++;
+    if (elapsed > _maxLoop)
+      _maxLoop = elapsed;
+  }
+  _lastMark = now;
+  _marked = true;
+}
+
+void ThermostatProfiler::reset()
+{
+  for (uint8_t i = 0; i < _count; i++)
+    _phases[i] = {_phases[i].name, 0, UINT32_MAX, 0, 0, {0}};
+  _loops = _maxLoop = 0;
+  _elapsed = 0;
+}
+
+// {"profile":{"loops":N,"hz":F,"stall":us,"phases":{"name":[min,avg,max],...}}}
+// in microseconds; returns the length, or 0 when the buffer is too small.
+size_t ThermostatProfiler::format(char *buffer, size_t size)
+{
+  int length = snprintf(buffer, size, "{\"profile\":{\"loops\":%u,\"hz\":%.1f,\"stall\":%u,\"phases\":{", _loops, getLoopsPerSecond(), getMaxLoopMicros());
+  for (uint8_t i = 0; i < _count && length > 0 && (size_t)length < size; i++)
+  {
+    const Phase &p = _phases[i];
+    if (p.count == 0)
+      continue;
+    length += snprintf(buffer + length, size - length, "%s\"%s\":[%u,%u,%u]", buffer[length - 1] == '{' ? "" : ",", p.name, toMicros(p.min), toMicros(p.total / p.count), toMicros(p.max));
+  }
+  if (length > 0 && (size_t)length < size)
+    length += snprintf(buffer + length, size - length, "}}}");
+  return length > 0 && (size_t)length < size ? length : 0;
+}
@@ -0,0 +1,53 @@
+#ifndef ThermostatProfiler_H
+#define ThermostatProfiler_H
+
+#include "Arduino.h"
+#include "ThermostatScheduler.h"
+
+#define PROFILER_PHASES SCHEDULER_TASKS // one per scheduler task
+#define PROFILER_BUCKETS 24 // log2 histogram, 1 cycle .. 2^23 cycles
+
+// Cycle-count profile of the main loop, per phase: count, min/avg/max and
+// a log2 histogram of durations, plus loop rate and the worst stall. The
+// clock is the CPU cycle counter on the ESP8266 and micros() elsewhere, so
+// recording a phase costs a few instructions.
+class ThermostatProfiler
+{
+public:
+  struct Phase
+  {
+    const char *name;
+    uint32_t count, min, max;
+    uint64_t total;
+    uint32_t buckets[PROFILER_BUCKETS];
+  };
+
+  static inline uint32_t cycles()
+  {
+#ifdef ESP8266
+    return ESP.getCycleCount();
+#else
+    return micros();
+#endif
+  }
+
+  void record(uint8_t phase, const char *name, uint32_t cycles);
+  void mark();
+  void reset();
+  uint8_t getCount();
+  const Phase &getPhase(uint8_t index);
+  uint32_t getLoops();
+  float getLoopsPerSecond();
+  uint32_t getMaxLoopMicros();
+  uint32_t toMicros(uint64_t cycles);
+  size_t format(char *buffer, size_t size);
+
+private:
+  Phase _phases[PROFILER_PHASES];
+  uint8_t _count = 0;
+  bool _marked = false;
+  uint32_t _lastMark = 0, _loops = 0, _maxLoop = 0;
+  uint64_t _elapsed = 0;
+};
+
+#endif
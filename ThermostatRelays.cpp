@@ -0,0 +1,78 @@
+#include "ThermostatRelays.h"
+
+ThermostatRelays::ThermostatRelays(uint8_t pinFan, uint8_t pinCool, uint8_t pinHeat)
+{
+  _pins[0] = pinFan;
+  _pins[1] = pinCool;
+  _pins[2] = pinHeat;
+}
+
+uint8_t ThermostatRelays::getOutputs() { return _shadow; }
+uint32_t ThermostatRelays::getRequests() { return _requests; }
+uint32_t ThermostatRelays::getWrites() { return _writes; }
+uint32_t ThermostatRelays::getInterlocks() { return _interlocks; }
+
+void ThermostatRelays::begin()
+{
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    pinMode(_pins[i], OUTPUT);
+    digitalWrite(_pins[i], HIGH);
+  }
+  _shadow = 0;
+}
+
+void ThermostatRelays::write(uint8_t outputs)
+{
+  _requests++;
+  if ((outputs & RELAY_COOL) && (outputs & RELAY_HEAT))
+  {
+    outputs &= ~(RELAY_COOL | RELAY_HEAT);
+    _interlocks++;
+  }
+  if (outputs == _shadow)
+    return;
+  apply(outputs);
+  _shadow = outputs;
+  _writes++;
+}
+
+#ifdef ESP8266
+void ThermostatRelays::apply(uint8_t outputs)
+{
+  uint32_t mask = 0, levels = 0;
+  bool on16 = false, use16 = false;
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    bool on = outputs & (1 << i);
+    if (_pins[i] == 16)
+    {
+      use16 = true;
+      on16 = on;
+      continue;
+    }
+    mask |= 1UL << _pins[i];
+    if (!on)
+      levels |= 1UL << _pins[i]; // active low
+  }
+  // GPIO16 sits outside the GPO register: release it before, energize after
+  if (use16 && !on16)
+    GP16O |= 1;
+  noInterrupts();
+  GPO = (GPO & ~mask) | levels;
+  interrupts();
+  if (use16 && on16)
+    GP16O &= ~1;
+}
+#else
+void ThermostatRelays::apply(uint8_t outputs)
+{
+  // release first so two relays are never energized in between
+  for (uint8_t i = 0; i < 3; i++)
+    if (!(outputs & (1 << i)))
+      digitalWrite(_pins[i], HIGH);
+  for (uint8_t i = 0; i < 3; i++)
+    if (outputs & (1 << i))
+      digitalWrite(_pins[i], LOW);
+}
+#endif
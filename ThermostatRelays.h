@@ -0,0 +1,32 @@
+#ifndef ThermostatRelays_H
+#define ThermostatRelays_H
+
+#include "Arduino.h"
+
+#define RELAY_FAN 0x01
+#define RELAY_COOL 0x02
+#define RELAY_HEAT 0x04
+
+// Active-low fan/cool/heat relay outputs behind a shadow register. Writes
+// equal to the shadow are skipped, heat and cool are never energized
+// together, and on the ESP8266 every relay on the GPIO block changes with
+// a single store to the output register, so no intermediate state exists.
+class ThermostatRelays
+{
+public:
+  ThermostatRelays(uint8_t pinFan, uint8_t pinCool, uint8_t pinHeat);
+  void begin();
+  void write(uint8_t outputs);
+  uint8_t getOutputs();
+  uint32_t getRequests();
+  uint32_t getWrites();
+  uint32_t getInterlocks();
+
+private:
+  uint8_t _pins[3];
+  uint8_t _shadow = 0;
+  uint32_t _requests = 0, _writes = 0, _interlocks = 0;
+  void apply(uint8_t outputs);
+};
+
+#endif
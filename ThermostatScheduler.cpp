@@ -0,0 +1,65 @@
+#include "ThermostatScheduler.h"
+#if THERMOSTAT_PROFILE
+#include "ThermostatProfiler.h"
+#endif
+
+uint8_t ThermostatScheduler::getCount() { return _count; }
+const ThermostatScheduler::Task &ThermostatScheduler::getTask(uint8_t index) { return _tasks[index]; }
+#if THERMOSTAT_PROFILE
+void ThermostatScheduler::setProfiler(ThermostatProfiler *profiler) { _profiler = profiler; }
+#endif
+
+bool ThermostatScheduler::add(const char *name, std::function<void()> run, unsigned long period, uint8_t priority, uint32_t budget)
+{
+  if (_count >= SCHEDULER_TASKS)
+    return false;
+  // keep the table sorted by priority so loop() is a single pass
+  uint8_t i = _count++;
+  for (; i > 0 && _tasks[i - 1].priority > priority; i--)
+    _tasks[i] = _tasks[i - 1];
+  _tasks[i] = {name, run, period, millis(), budget, priority, 0, 0, 0, 0, 0};
+  return true;
+}
+
+void ThermostatScheduler::loop()
+{
+  for (uint8_t i = 0; i < _count; i++)
+  {
+    Task &task = _tasks[i];
+    unsigned long now = millis();
+    if (task.period > 0)
+    {
+      unsigned long waited = now - task.last;
+      if (waited < task.period)
+        continue;
+      if (waited >= 2 * task.period)
+        task.late++;
+      task.last = now;
+    }
+
+#if THERMOSTAT_PROFILE
+    uint32_t startCycles = _profiler != NULL ? ThermostatProfiler::cycles() : 0;
+#endif
+    uint32_t start = micros();
+    task.run();
+    uint32_t elapsed = micros() - start;
+#if THERMOSTAT_PROFILE
+    if (_profiler != NULL)
+      _profiler->record(i, task.name, ThermostatProfiler::cycles() - startCycles);
+#endif
+    task.runs++;
+    task.totalMicros += elapsed;
+    task.maxMicros = max(task.maxMicros, elapsed);
+    if (task.budget > 0 && elapsed > task.budget)
+      task.overruns++;
+  }
+}
+
+void ThermostatScheduler::resetStats()
+{
+  for (uint8_t i = 0; i < _count; i++)
+  {
+    Task &task = _tasks[i];
+    task.runs = task.totalMicros = task.maxMicros = task.overruns = task.late = 0;
+  }
+}
@@ -0,0 +1,53 @@
+#ifndef ThermostatScheduler_H
+#define ThermostatScheduler_H
+
+#include "Arduino.h"
+
+#define SCHEDULER_TASKS 16
+
+// Build flag (build_opt.h on the ESP8266): 1 lets a ThermostatProfiler
+// record every task run; 0 compiles the hooks out of loop().
+#ifndef THERMOSTAT_PROFILE
+#define THERMOSTAT_PROFILE 0
+#endif
+
+#if THERMOSTAT_PROFILE
+class ThermostatProfiler;
+#endif
+
+// Cooperative scheduler for the main loop. Tasks run in priority order
+// (0 first) whenever their period has elapsed; a period of 0 runs the task
+// on every pass. Each task keeps its own runtime and overrun statistics;
+// with THERMOSTAT_PROFILE and a profiler set, every run is also recorded
+// there in CPU cycles.
+class ThermostatScheduler
+{
+public:
+  struct Task
+  {
+    const char *name;
+    std::function<void()> run;
+    unsigned long period, last;
+    uint32_t budget; // us, 0 disables overrun detection
+    uint8_t priority;
+    uint32_t runs, totalMicros, maxMicros, overruns, late;
+  };
+
+  bool add(const char *name, std::function<void()> run, unsigned long period = 0, uint8_t priority = 0, uint32_t budget = 0);
+  void loop();
+  void resetStats();
+#if THERMOSTAT_PROFILE
+  void setProfiler(ThermostatProfiler *profiler);
+#endif
+  uint8_t getCount();
+  const Task &getTask(uint8_t index);
+
+private:
+  Task _tasks[SCHEDULER_TASKS];
+  uint8_t _count = 0;
+#if THERMOSTAT_PROFILE
+  ThermostatProfiler *_profiler = NULL;
+#endif
+};
+
+#endif
@@ -0,0 +1,86 @@
+#include "ThermostatSensor.h"
+
+ThermostatSensor::ThermostatSensor(ThermostatDHT *dht, unsigned long interval)
+{
+  _dht = dht;
+  _interval = interval;
+}
+
+void ThermostatSensor::begin() { _dht->begin(); }
+void ThermostatSensor::setSmoothing(float alpha) { _alpha = alpha; }
+void ThermostatSensor::setOnSample(std::function<void(float, float)> func) { _onSample = func; }
+bool ThermostatSensor::isValid() { return !isnan(_temperature); }
+unsigned long ThermostatSensor::getAge() { return millis() - _lastValid; }
+uint32_t ThermostatSensor::getReads() { return _reads; }
+uint32_t ThermostatSensor::getErrors() { return _dht->getErrors(); }
+uint32_t ThermostatSensor::getHits() { return _hits; }
+uint32_t ThermostatSensor::getReadMicros() { return _readMicros; }
+uint32_t ThermostatSensor::getMaxReadMicros() { return _maxReadMicros; }
+
+float ThermostatSensor::getTemperature()
+{
+  _hits++;
+  return _temperature;
+}
+
+float ThermostatSensor::getHumidity()
+{
+  _hits++;
+  return _humidity;
+}
+
+// Drives the DHT conversion without blocking: a new one is started every
+// interval and its result is filtered in whenever the driver has decoded it.
+void ThermostatSensor::loop()
+{
+  unsigned long now = millis();
+  uint32_t start = micros();
+  _dht->loop();
+  if (!_dht->isBusy() && (_reads == 0 || now - _lastSample >= _interval))
+  {
+    _lastSample = now;
+    _reads++;
+    _dht->start();
+  }
+  uint32_t elapsed = micros() - start;
+  _readMicros += elapsed;
+  _maxReadMicros = max(_maxReadMicros, elapsed);
+
+  if (!_dht->available())
+    return;
+  float temperature = _dht->readTemperature();
+  float humidity = _dht->readHumidity();
+  if (_onSample != NULL)
+    _onSample(temperature, humidity);
+  if (isnan(temperature) || isnan(humidity))
+    return;
+  _temperatures[_next] = temperature;
+  _humidities[_next] = humidity;
+  _next = (_next + 1) % SENSOR_WINDOW;
+  if (_count < SENSOR_WINDOW)
+    _count++;
+
+  _temperature = smooth(_temperature, median(_temperatures, _count), _alpha);
+  _humidity = smooth(_humidity, median(_humidities, _count), _alpha);
+  _lastValid = now;
+}
+
+float ThermostatSensor::median(const float *values, uint8_t count)
+{
+  float sorted[SENSOR_WINDOW];
+  for (uint8_t i = 0; i < count; i++)
+  {
+    uint8_t j = i;
+    for (; j > 0 && sorted[j - 1] > values[i]; j--)
+      sorted[j] = sorted[j - 1];
+    sorted[j] = values[i];
+  }
+  return sorted[count / 2];
+}
+
+float ThermostatSensor::smooth(float current, float sample, float alpha)
+{
+  if (isnan(current))
+    return sample;
+  return current + alpha * (sample - current);
+}
@@ -0,0 +1,40 @@
+#ifndef ThermostatSensor_H
+#define ThermostatSensor_H
+
+#include "Arduino.h"
+#include "ThermostatDHT.h"
+
+#define SENSOR_INTERVAL 2000 // DHT minimum sampling period, in ms
+#define SENSOR_WINDOW 3      // median filter length
+
+class ThermostatSensor
+{
+public:
+  ThermostatSensor(ThermostatDHT *dht, unsigned long interval = SENSOR_INTERVAL);
+  void begin();
+  void loop();
+  void setSmoothing(float alpha);
+  void setOnSample(std::function<void(float, float)> func);
+  float getTemperature();
+  float getHumidity();
+  bool isValid();
+  unsigned long getAge();
+  uint32_t getReads();
+  uint32_t getHits();
+  uint32_t getErrors();
+  uint32_t getReadMicros();
+  uint32_t getMaxReadMicros();
+
+private:
+  ThermostatDHT *_dht;
+  std::function<void(float, float)> _onSample;
+  unsigned long _interval, _lastSample = 0, _lastValid = 0;
+  float _alpha = 0.5, _temperature = NAN, _humidity = NAN;
+  float _temperatures[SENSOR_WINDOW], _humidities[SENSOR_WINDOW];
+  uint8_t _count = 0, _next = 0;
+  uint32_t _reads = 0, _hits = 0, _readMicros = 0, _maxReadMicros = 0;
+  static float median(const float *values, uint8_t count);
+  static float smooth(float current, float sample, float alpha);
+};
+
+#endif
@@ -0,0 +1,68 @@
+#include "ThermostatSimulation.h"
+
+ThermostatSimulation::ThermostatSimulation(float temperature) { _temperature = temperature; }
+
+void ThermostatSimulation::setOutdoor(float outdoor) { _outdoor = outdoor; }
+void ThermostatSimulation::setTimeConstant(unsigned long tau) { _tau = tau; }
+float ThermostatSimulation::getTemperature() { return _temperature; }
+uint64_t ThermostatSimulation::getElapsed() { return _elapsed; }
+uint64_t ThermostatSimulation::getCompressorMillis() { return _compressorMillis; }
+uint64_t ThermostatSimulation::getFanMillis() { return _fanMillis; }
+
+void ThermostatSimulation::setGains(float heat, float cool)
+{
+  _heatGain = heat;
+  _coolGain = cool;
+}
+
+void ThermostatSimulation::setPower(uint16_t compressor, uint16_t fan)
+{
+  _compressorWatts = compressor;
+  _fanWatts = fan;
+}
+
+// watt-hours drawn so far
+float ThermostatSimulation::getEnergy()
+{
+  return (_compressorMillis / 3600000.0) * _compressorWatts + (_fanMillis / 3600000.0) * _fanWatts;
+}
+
+// mean |temperature - point| while heating or cooling was selected
+float ThermostatSimulation::getComfortError()
+{
+  return _activeMillis > 0 ? _errorIntegral / _activeMillis : 0;
+}
+
+void ThermostatSimulation::step(uint8_t outputs, ThermostatState state, float point, uint64_t now)
+{
+  if (!_started)
+  {
+    _last = now;
+    _started = true;
+    return;
+  }
+  uint64_t dt = now - _last;
+  _last = now;
+  if (dt == 0)
+    return;
+
+  // the outputs held over the whole step: integrate exactly
+  float target = _outdoor;
+  if (outputs & RELAY_HEAT)
+    target += _heatGain;
+  else if (outputs & RELAY_COOL)
+    target -= _coolGain;
+  float before = _temperature;
+  _temperature = target + (_temperature - target) * expf(-(float)dt / _tau);
+
+  _elapsed += dt;
+  if (outputs & (RELAY_HEAT | RELAY_COOL))
+    _compressorMillis += dt;
+  if (outputs & RELAY_FAN)
+    _fanMillis += dt;
+  if ((state == HEAT || state == COOL) && !isnan(point))
+  {
+    _activeMillis += dt;
+    _errorIntegral += fabs((before + _temperature) / 2 - point) * dt;
+  }
+}
@@ -0,0 +1,46 @@
+#ifndef ThermostatSimulation_H
+#define ThermostatSimulation_H
+
+#include "Arduino.h"
+#include "Thermostat.h"
+
+#define SIMULATION_OUTDOOR 30.0     // degrees
+#define SIMULATION_INDOOR 24.0      // starting room temperature
+#define SIMULATION_TAU 3600000      // room time constant, in ms
+#define SIMULATION_HEAT_GAIN 20.0   // steady-state rise over outdoor
+#define SIMULATION_COOL_GAIN 15.0   // steady-state drop under outdoor
+#define SIMULATION_COMPRESSOR 1200  // watts
+#define SIMULATION_FAN 80           // watts
+
+// First-order room model driven by the relay outputs, for trying control
+// settings without a plant. The room relaxes toward the outdoor temperature
+// shifted by the heat or cool gain with time constant tau; each step is
+// integrated exactly, so long steps (sped-up clocks) stay stable. Tracks
+// run time, energy and the comfort error against the point. Time is kept
+// in 64 bits, so a sped-up clock can run past the 49 days of millis().
+class ThermostatSimulation
+{
+public:
+  ThermostatSimulation(float temperature = SIMULATION_INDOOR);
+  void setOutdoor(float outdoor);
+  void setTimeConstant(unsigned long tau);
+  void setGains(float heat, float cool);
+  void setPower(uint16_t compressor, uint16_t fan);
+  void step(uint8_t outputs, ThermostatState state, float point, uint64_t now);
+  float getTemperature();
+  uint64_t getElapsed();
+  uint64_t getCompressorMillis();
+  uint64_t getFanMillis();
+  float getEnergy();
+  float getComfortError();
+
+private:
+  float _temperature, _outdoor = SIMULATION_OUTDOOR;
+  float _tau = SIMULATION_TAU, _heatGain = SIMULATION_HEAT_GAIN, _coolGain = SIMULATION_COOL_GAIN;
+  uint16_t _compressorWatts = SIMULATION_COMPRESSOR, _fanWatts = SIMULATION_FAN;
+  bool _started = false;
+  uint64_t _last = 0, _elapsed = 0, _compressorMillis = 0, _fanMillis = 0, _activeMillis = 0;
+  double _errorIntegral = 0; // degree-milliseconds, too many for a float
+};
+
+#endif
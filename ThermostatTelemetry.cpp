@@ -0,0 +1,45 @@
+#include "ThermostatTelemetry.h"
+
+static const char TPL_POWER_STATE[] PROGMEM = "{\"deviceId\":\"%s\",\"action\":\"setPowerState\",\"value\":\"%s\"}";
+static const char TPL_THERMOSTAT_MODE[] PROGMEM = "{\"deviceId\":\"%s\",\"action\":\"SetThermostatMode\",\"value\":\"%s\"}";
+static const char TPL_TEMPERATURE_SETTING[] PROGMEM = "{\"action\":\"SetTemperatureSetting\",\"deviceId\":\"%s\",\"value\":{\"temperatureSetting\":"
+                                                      "{\"setPoint\":%s,\"scale\":\"%s\",\"ambientTemperature\":%s,\"ambientHumidity\":%s}}}";
+
+char ThermostatTelemetry::_buffer[TELEMETRY_BUFFER];
+size_t ThermostatTelemetry::_length = 0;
+
+size_t ThermostatTelemetry::length() { return _length; }
+
+const char *ThermostatTelemetry::powerState(const char *deviceId, const char *value)
+{
+  return finish(snprintf_P(_buffer, sizeof(_buffer), TPL_POWER_STATE, deviceId, value));
+}
+
+const char *ThermostatTelemetry::thermostatMode(const char *deviceId, const char *mode)
+{
+  return finish(snprintf_P(_buffer, sizeof(_buffer), TPL_THERMOSTAT_MODE, deviceId, mode));
+}
+
+const char *ThermostatTelemetry::temperatureSetting(const char *deviceId, float setPoint, const char *scale, float temperature, float humidity)
+{
+  char point[12], ambient[12], humid[12];
+  return finish(snprintf_P(_buffer, sizeof(_buffer), TPL_TEMPERATURE_SETTING, deviceId,
+                           number(point, sizeof(point), setPoint), scale,
+                           number(ambient, sizeof(ambient), temperature),
+                           number(humid, sizeof(humid), humidity)));
+}
+
+// JSON has no NaN, so a missing reading is sent as null
+const char *ThermostatTelemetry::number(char *out, size_t size, float value)
+{
+  if (isnan(value))
+    return "null";
+  snprintf(out, size, "%.1f", value);
+  return out;
+}
+
+const char *ThermostatTelemetry::finish(int written)
+{
+  _length = written < 0 ? 0 : min((size_t)written, sizeof(_buffer) - 1);
+  return _buffer;
+}
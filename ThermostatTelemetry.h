@@ -0,0 +1,26 @@
+#ifndef ThermostatTelemetry_H
+#define ThermostatTelemetry_H
+
+#include "Arduino.h"
+
+#define TELEMETRY_BUFFER 256
+
+// Encodes the outbound Sinric messages from fixed templates straight into
+// a static buffer: no JSON document, no String and no heap per message.
+// The returned pointer stays valid until the next encode call.
+class ThermostatTelemetry
+{
+public:
+  static const char *powerState(const char *deviceId, const char *value);
+  static const char *thermostatMode(const char *deviceId, const char *mode);
+  static const char *temperatureSetting(const char *deviceId, float setPoint, const char *scale, float temperature, float humidity);
+  static size_t length();
+
+private:
+  static char _buffer[TELEMETRY_BUFFER];
+  static size_t _length;
+  static const char *number(char *out, size_t size, float value);
+  static const char *finish(int written);
+};
+
+#endif
@@ -0,0 +1,216 @@
+#include "ThermostatTrace.h"
+
+ThermostatTraceWriter::ThermostatTraceWriter(Print *out) { _out = out; }
+
+uint32_t ThermostatTraceWriter::getRecords() { return _records; }
+uint32_t ThermostatTraceWriter::getBytes() { return _bytes; }
+
+void ThermostatTraceWriter::begin()
+{
+  _out->write((const uint8_t *)TRACE_MAGIC, 4);
+  _bytes += 4;
+  _last = millis();
+  _started = true;
+  uint32_t now = _last;
+  record(TRACE_START, (const uint8_t *)&now, sizeof(now));
+}
+
+void ThermostatTraceWriter::sensor(float temperature, float humidity)
+{
+  float payload[2] = {temperature, humidity};
+  record(TRACE_SENSOR, (const uint8_t *)payload, sizeof(payload));
+}
+
+void ThermostatTraceWriter::ir(const decode_results *results)
+{
+  uint8_t header[4];
+  int16_t type = results->decode_type;
+  memcpy(header, &type, 2);
+  memcpy(header + 2, &results->bits, 2);
+  size_t bytes = min((size_t)((results->bits + 7) / 8), (size_t)kStateSizeMax);
+  record(TRACE_IR, header, sizeof(header), results->state, bytes);
+}
+
+void ThermostatTraceWriter::frame(const uint8_t *payload, size_t length)
+{
+  record(TRACE_FRAME, payload, length);
+}
+
+void ThermostatTraceWriter::button(const ButtonEdge *edge)
+{
+  uint8_t payload[7] = {edge->index, edge->pressed};
+  size_t length = 2 + encodeVarint(payload + 2, millis() - edge->millis);
+  record(TRACE_BUTTON, payload, length);
+}
+
+void ThermostatTraceWriter::wifi(bool connected, int8_t rssi, const char *ssid)
+{
+  uint8_t header[2] = {connected, (uint8_t)rssi};
+  record(TRACE_WIFI, header, sizeof(header), (const uint8_t *)ssid, strlen(ssid));
+}
+
+void ThermostatTraceWriter::cloud(bool connected)
+{
+  uint8_t payload = connected;
+  record(TRACE_CLOUD, &payload, 1);
+}
+
+void ThermostatTraceWriter::portal(const char *deviceId)
+{
+  record(TRACE_PORTAL, (const uint8_t *)deviceId, strlen(deviceId));
+}
+
+void ThermostatTraceWriter::record(ThermostatTraceType type, const uint8_t *payload, size_t length, const uint8_t *tail, size_t tailLength)
+{
+  if (!_started)
+    return;
+  unsigned long now = millis();
+  _out->write((uint8_t)type);
+  _bytes++;
+  writeVarint(now - _last);
+  writeVarint(length + tailLength);
+  _bytes += _out->write(payload, length);
+  if (tailLength > 0)
+    _bytes += _out->write(tail, tailLength);
+  _last = now;
+  _records++;
+}
+
+void ThermostatTraceWriter::writeVarint(uint32_t value)
+{
+  uint8_t buffer[5];
+  _bytes += _out->write(buffer, encodeVarint(buffer, value));
+}
+
+// LEB128: 7 bits per byte, low group first, high bit set on all but the last
+size_t ThermostatTraceWriter::encodeVarint(uint8_t *buffer, uint32_t value)
+{
+  size_t length = 0;
+  do
+  {
+    buffer[length++] = (value & 0x7F) | (value > 0x7F ? 0x80 : 0);
+    value >>= 7;
+  } while (value > 0);
+  return length;
+}
+
+ThermostatTraceReader::ThermostatTraceReader(const uint8_t *data, size_t length)
+{
+  _data = data;
+  _length = length;
+  _offset = 4;
+}
+
+bool ThermostatTraceReader::isValid()
+{
+  return _length >= 4 && memcmp(_data, TRACE_MAGIC, 4) == 0;
+}
+
+// Returns false at the end of the trace or on a truncated record.
+bool ThermostatTraceReader::next(Record *record)
+{
+  if (!isValid() || _offset >= _length)
+    return false;
+  size_t offset = _offset;
+  uint8_t type = _data[offset++];
+  uint32_t delta, length;
+  if (!readVarint(_data, _length, &offset, &delta) || !readVarint(_data, _length, &offset, &length) || length > _length - offset)
+    return false;
+  record->type = (ThermostatTraceType)type;
+  record->payload = _data + offset;
+  record->length = length;
+  // the START record carries the absolute clock the deltas build on
+  if (type == TRACE_START && length >= 4)
+  {
+    uint32_t start;
+    memcpy(&start, record->payload, 4);
+    _millis = start;
+  }
+  else
+    _millis += delta;
+  record->millis = _millis;
+  _offset = offset + length;
+  return true;
+}
+
+bool ThermostatTraceReader::toSensor(const Record *record, float *temperature, float *humidity)
+{
+  if (record->type != TRACE_SENSOR || record->length != 8)
+    return false;
+  memcpy(temperature, record->payload, 4);
+  memcpy(humidity, record->payload + 4, 4);
+  return true;
+}
+
+bool ThermostatTraceReader::toIR(const Record *record, decode_results *results)
+{
+  if (record->type != TRACE_IR || record->length < 4 || record->length - 4 > kStateSizeMax)
+    return false;
+  int16_t type;
+  memcpy(&type, record->payload, 2);
+  memcpy(&results->bits, record->payload + 2, 2);
+  results->decode_type = (decode_type_t)type;
+  memset(results->state, 0, kStateSizeMax);
+  memcpy(results->state, record->payload + 4, record->length - 4);
+  return true;
+}
+
+bool ThermostatTraceReader::toButton(const Record *record, ButtonEdge *edge)
+{
+  if (record->type != TRACE_BUTTON || record->length < 3)
+    return false;
+  size_t offset = 2;
+  uint32_t age;
+  if (!readVarint(record->payload, record->length, &offset, &age))
+    return false;
+  edge->index = record->payload[0];
+  edge->pressed = record->payload[1] != 0;
+  edge->millis = record->millis - age;
+  return true;
+}
+
+bool ThermostatTraceReader::toWifi(const Record *record, bool *connected, int8_t *rssi, char *ssid, size_t size)
+{
+  if (record->type != TRACE_WIFI || record->length < 2)
+    return false;
+  *connected = record->payload[0] != 0;
+  *rssi = (int8_t)record->payload[1];
+  copyText(record->payload + 2, record->length - 2, ssid, size);
+  return true;
+}
+
+bool ThermostatTraceReader::toCloud(const Record *record, bool *connected)
+{
+  if (record->type != TRACE_CLOUD || record->length != 1)
+    return false;
+  *connected = record->payload[0] != 0;
+  return true;
+}
+
+bool ThermostatTraceReader::toPortal(const Record *record, char *deviceId, size_t size)
+{
+  if (record->type != TRACE_PORTAL)
+    return false;
+  copyText(record->payload, record->length, deviceId, size);
+  return true;
+}
+
+void ThermostatTraceReader::copyText(const uint8_t *text, size_t length, char *out, size_t size)
+{
+  length = min(length, size - 1);
+  memcpy(out, text, length);
+  out[length] = 0;
+}
+
+bool ThermostatTraceReader::readVarint(const uint8_t *data, size_t length, size_t *offset, uint32_t *value)
+{
+  *value = 0;
+  for (uint8_t shift = 0; shift < 35 && *offset < length; shift += 7)
+  {
+    uint8_t byte = data[(*offset)++];
+    *value |= (uint32_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80))
+      return true;
+  }
+  return false;
+}
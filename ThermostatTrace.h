@@ -0,0 +1,91 @@
+#ifndef ThermostatTrace_H
+#define ThermostatTrace_H
+
+#include "Arduino.h"
+#include "IRrecv.h"
+#include "ButtonEvent.h"
+
+#define TRACE_MAGIC "TRC1"
+
+// Compact binary trace of the loop inputs. After the 4 byte magic every
+// record is
+//   type (1 byte) | ms since the previous record (varint) | length (varint) | payload
+// with little-endian payloads:
+//   START  millis (u32)
+//   SENSOR temperature (f32), humidity (f32), NaN for a failed read
+//   IR     decode type (i16), bits (u16), state bytes
+//   FRAME  WebSocket text as received
+//   BUTTON handle (u8), pressed (u8), ms the edge waited in the ring (varint)
+//   WIFI   connected (u8), RSSI (i8), SSID
+//   CLOUD  connected (u8), the Sinric socket opening or closing
+//   PORTAL device id saved from the captive portal page
+enum ThermostatTraceType : uint8_t
+{
+  TRACE_START,
+  TRACE_SENSOR,
+  TRACE_IR,
+  TRACE_FRAME,
+  TRACE_BUTTON,
+  TRACE_WIFI,
+  TRACE_CLOUD,
+  TRACE_PORTAL
+};
+
+class ThermostatTraceWriter
+{
+public:
+  ThermostatTraceWriter(Print *out);
+  void begin();
+  void sensor(float temperature, float humidity);
+  void ir(const decode_results *results);
+  void frame(const uint8_t *payload, size_t length);
+  void button(const ButtonEdge *edge);
+  void wifi(bool connected, int8_t rssi, const char *ssid);
+  void cloud(bool connected);
+  void portal(const char *deviceId);
+  uint32_t getRecords();
+  uint32_t getBytes();
+
+private:
+  Print *_out;
+  bool _started = false;
+  unsigned long _last = 0;
+  uint32_t _records = 0, _bytes = 0;
+  void record(ThermostatTraceType type, const uint8_t *payload, size_t length, const uint8_t *tail = NULL, size_t tailLength = 0);
+  void writeVarint(uint32_t value);
+  static size_t encodeVarint(uint8_t *buffer, uint32_t value);
+};
+
+// Walks a trace held in memory, record by record; payloads point into the
+// trace itself, so nothing is copied.
+class ThermostatTraceReader
+{
+public:
+  struct Record
+  {
+    ThermostatTraceType type;
+    unsigned long millis;
+    const uint8_t *payload;
+    size_t length;
+  };
+
+  ThermostatTraceReader(const uint8_t *data, size_t length);
+  bool isValid();
+  bool next(Record *record);
+  static bool toSensor(const Record *record, float *temperature, float *humidity);
+  static bool toIR(const Record *record, decode_results *results);
+  static bool toButton(const Record *record, ButtonEdge *edge);
+  // SSID and device id are copied NUL-terminated, cut to size
+  static bool toWifi(const Record *record, bool *connected, int8_t *rssi, char *ssid, size_t size);
+  static bool toCloud(const Record *record, bool *connected);
+  static bool toPortal(const Record *record, char *deviceId, size_t size);
+
+private:
+  const uint8_t *_data;
+  size_t _length, _offset;
+  unsigned long _millis = 0;
+  static bool readVarint(const uint8_t *data, size_t length, size_t *offset, uint32_t *value);
+  static void copyText(const uint8_t *text, size_t length, char *out, size_t size);
+};
+
+#endif
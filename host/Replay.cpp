@@ -0,0 +1,163 @@
+#include "Replay.h"
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <Host.h>
+#include <IRrecv.h>
+#include "ThermostatTrace.h"
+#include <vector>
+
+// Thermostat.ino's lines
+#define PIN_FAN D0
+#define PIN_BTN D3
+#define PIN_LED D4
+#define PIN_COOL D5
+#define PIN_HEAT D6
+#define PIN_DHT D9
+
+#define SAMPLE_WINDOW 1000 // ms from a start pulse to its sample, half the sensor interval
+
+void setup();
+void loop();
+
+// buttons by handle, in the order setup() adds them
+static const uint8_t BUTTON_PINS[] = {PIN_BTN};
+static const uint8_t LOG_PINS[] = {PIN_FAN, PIN_COOL, PIN_HEAT, PIN_LED};
+
+namespace Replay
+{
+  void Log::attach()
+  {
+    Host::setOnWrite([this](uint8_t pin, uint8_t level) { write(pin, level); });
+    Host::setOnCloudText([this](const char *text, size_t length) {
+      cloud += std::to_string(millis()) + " ";
+      cloud.append(text, length);
+      cloud += "\n";
+    });
+  }
+
+  void Log::write(uint8_t pin, uint8_t level)
+  {
+    for (size_t i = 0; i < sizeof(LOG_PINS); i++)
+      if (LOG_PINS[i] == pin && _levels[i] != level)
+      {
+        _levels[i] = level;
+        relays += std::to_string(millis()) + " D" + std::to_string(pin) + (level == LOW ? " on\n" : " off\n");
+      }
+  }
+
+  // FNV-1a of the panel RAM, only when I2C traffic reached it
+  void Log::sample()
+  {
+    if (Host::getPanelBytes() == _panelBytes)
+      return;
+    _panelBytes = Host::getPanelBytes();
+    uint64_t hash = 0xCBF29CE484222325ull;
+    const uint8_t *ram = Host::getPanel();
+    for (size_t i = 0; i < 8 * 128; i++)
+      hash = (hash ^ ram[i]) * 0x100000001B3ull;
+    if (hash == _panelHash)
+      return;
+    _panelHash = hash;
+    char line[40];
+    snprintf(line, sizeof(line), "%lu %016llx\n", millis(), (unsigned long long)hash);
+    panel += line;
+  }
+
+  void attachHardware()
+  {
+    Host::attachDHT(PIN_DHT, 11);
+    Host::attachPanel(0x3C);
+  }
+
+  // At a start pulse the DHT answers with the sample the trace has due from
+  // it; with none due the read failed on the device, and the DHT is silent.
+  static void answer(const std::vector<ThermostatTraceReader::Record> &records, size_t *sensor)
+  {
+    while (*sensor < records.size() && (records[*sensor].type != TRACE_SENSOR || records[*sensor].millis < millis()))
+      (*sensor)++;
+    float temperature = NAN, humidity = NAN;
+    if (*sensor < records.size() && records[*sensor].millis - millis() < SAMPLE_WINDOW)
+      ThermostatTraceReader::toSensor(&records[(*sensor)++], &temperature, &humidity);
+    Host::setDHT(temperature, humidity);
+  }
+
+  bool run(const uint8_t *trace, size_t length, unsigned long end, Log *log)
+  {
+    ThermostatTraceReader reader(trace, length);
+    std::vector<ThermostatTraceReader::Record> records;
+    ThermostatTraceReader::Record record;
+    while (reader.next(&record))
+      records.push_back(record);
+    if (!reader.isValid() || records.empty() || records[0].type != TRACE_START)
+      return false;
+    unsigned long start = records[0].millis;
+    end = max(end, records.back().millis);
+
+    // edges are stamped by the interrupt, ahead of the record the ring
+    // drains them into, so they go on the line up front: at the start of
+    // their ms when the same pass drained them, else at its end
+    for (const ThermostatTraceReader::Record &r : records)
+    {
+      ButtonEdge edge;
+      if (ThermostatTraceReader::toButton(&r, &edge) && edge.index < sizeof(BUTTON_PINS))
+        Host::schedule((uint64_t)edge.millis * 1000 + (edge.millis < r.millis ? 999 : 0), BUTTON_PINS[edge.index], edge.pressed ? HIGH : LOW);
+    }
+    size_t sensor = 0;
+    Host::cloudAccept(false);
+    if (Host::getMicros() < (uint64_t)start * 1000)
+      Host::advance((uint64_t)start * 1000 - Host::getMicros());
+    if (log != NULL)
+      log->attach();
+    Host::setOnWrite([&](uint8_t pin, uint8_t level) {
+      if (pin == PIN_DHT && level == LOW)
+        answer(records, &sensor);
+      if (log != NULL)
+        log->write(pin, level);
+    });
+    setup();
+
+    // the portal page carries the device id and connects the station in the
+    // same pass, so the WIFI record after it is the portal's doing
+    char deviceId[32] = "", ssid[33];
+    bool portal = false;
+    size_t next = 1;
+    for (unsigned long ms = start; ms <= end; ms++)
+    {
+      for (; next < records.size() && records[next].millis <= ms; next++)
+      {
+        const ThermostatTraceReader::Record *r = &records[next];
+        bool connected;
+        int8_t rssi;
+        decode_results results;
+        if (r->type == TRACE_FRAME)
+          Host::cloudSend(std::string((const char *)r->payload, r->length).c_str());
+        else if (ThermostatTraceReader::toIR(r, &results))
+          Host::sendIR(results);
+        else if (ThermostatTraceReader::toPortal(r, deviceId, sizeof(deviceId)))
+          portal = true;
+        else if (ThermostatTraceReader::toWifi(r, &connected, &rssi, ssid, sizeof(ssid)))
+        {
+          if (!connected)
+            Host::wifiDisconnect();
+          else if (portal)
+            Host::submitPortal(ssid, {{"sinric_apiKey", "replay"}, {"sinric_devId", deviceId}});
+          else
+            Host::wifiConnect(ssid, rssi);
+          portal = false;
+        }
+        else if (ThermostatTraceReader::toCloud(r, &connected))
+        {
+          if (!connected)
+            Host::cloudClose();
+          Host::cloudAccept(connected);
+        }
+      }
+      loop();
+      if (log != NULL)
+        log->sample();
+      Host::advance(1000);
+    }
+    Host::setOnWrite(NULL);
+    return true;
+  }
+}
@@ -0,0 +1,40 @@
+#ifndef Replay_h
+#define Replay_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+// Plays a trace of Thermostat.ino's loop inputs (ThermostatTrace.h) back
+// into setup()/loop() on the virtual clock, so a session recorded on a
+// device or on the host runs again as fast as the CPU allows.
+namespace Replay
+{
+  // What the outside world saw of the sketch, one line per change stamped
+  // with millis(): the relay and LED lines, the panel RAM as a hash and the
+  // frames sent to the cloud. Runs fed the same inputs log the same text.
+  struct Log
+  {
+    std::string relays, panel, cloud;
+
+    void attach(); // before setup()
+    void sample(); // after every loop()
+    void write(uint8_t pin, uint8_t level);
+
+  private:
+    uint8_t _levels[4] = {0xFF, 0xFF, 0xFF, 0xFF};
+    uint32_t _panelBytes = 0;
+    uint64_t _panelHash = 0;
+  };
+
+  // The DHT and the panel where Thermostat.ino looks for them.
+  void attachHardware();
+
+  // Boots the sketch at the START record and plays the trace to its last
+  // record, or to end ms when that is later. Replay starts from erased
+  // flash, as the recording must have: the sketch is provisioned again by
+  // the PORTAL record. False when the trace does not parse.
+  bool run(const uint8_t *trace, size_t length, unsigned long end, Log *log);
+}
+
+#endif
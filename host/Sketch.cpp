@@ -0,0 +1,4 @@
+// Thermostat.ino as the Arduino IDE builds it: the core header first, then
+// the sketch, whose own prototypes stand in for the generated ones.
+#include <Arduino.h>
+#include "../Thermostat.ino"
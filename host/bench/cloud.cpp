@@ -0,0 +1,366 @@
+// A stand-in for the Sinric WebSocket server under load. The parent
+// process is the server: it listens on loopback, takes the RFC 6455
+// upgrade (the Basic apikey tells the devices apart), sends each device
+// ThermostatSetMode and ThermostatTemperatureSetpoint commands at a fixed
+// rate and reads the SetThermostatMode and SetTemperatureSetting frames
+// they send back. Every device is a forked process running Thermostat.ino
+// on the fake core, with its clock kept on wall time, so frames go
+// through the real WebSocketsClient event flow of the sketch: connect,
+// TEXT events from loop(), sendTXT().
+//
+// Devices report every relay change over a pipe with the time it was
+// seen. Figures are wall-time latencies from a command leaving the server
+// to its effect: the fan relay for a mode (fan or off), the telemetry
+// frame for a mode or a setpoint; then telemetry frames and bytes per
+// second, by action.
+//
+//   bench_cloud [-d devices] [-s seconds] [-r commands per device per second]
+#include <Arduino.h>
+#include <Host.h>
+#include <WebSockets.h>
+#include "ThermostatCommand.h"
+#include "ThermostatRelays.h"
+#include <arpa/inet.h>
+#include <chrono>
+#include <map>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <signal.h>
+#include <string>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#define PIN_FAN D0
+#define PIN_COOL D5
+#define PIN_HEAT D6
+#define PIN_DHT D9
+#define CONNECT_TIMEOUT 20 // s for every device to come online
+
+void setup();
+void loop();
+
+static uint64_t nanos()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct RelayReport
+{
+  uint32_t device;
+  uint8_t outputs;
+  uint64_t at;
+};
+
+// one thermostat: the sketch with its clock on wall time, until killed
+static void device(uint32_t index, uint16_t port, int report)
+{
+  prctl(PR_SET_PDEATHSIG, SIGTERM);
+  char key[16], id[16];
+  snprintf(key, sizeof(key), "key%u", index);
+  snprintf(id, sizeof(id), "dev%u", index);
+  Host::cloudServer("127.0.0.1", port);
+  Host::attachDHT(PIN_DHT, 11);
+  Host::setDHT(21, 45);
+  Host::attachPanel(0x3C);
+  setup();
+  Host::submitPortal("home", {{"sinric_apiKey", key}, {"sinric_devId", id}});
+
+  uint8_t outputs = 0;
+  uint64_t last = nanos();
+  for (;;)
+  {
+    loop();
+    uint8_t now = (Host::getOutput(PIN_FAN) == LOW ? RELAY_FAN : 0) | (Host::getOutput(PIN_COOL) == LOW ? RELAY_COOL : 0) |
+                  (Host::getOutput(PIN_HEAT) == LOW ? RELAY_HEAT : 0);
+    uint64_t at = nanos();
+    if (now != outputs)
+    {
+      RelayReport relay = {index, now, at};
+      if (write(report, &relay, sizeof(relay)) != sizeof(relay))
+        _exit(1);
+      outputs = now;
+    }
+    Host::advance((at - last) / 1000);
+    last = at - (at - last) % 1000;
+    usleep(100); // leave the cores to the other devices
+  }
+}
+
+// what a device owes the server: the time of the command still unanswered
+struct Pending
+{
+  uint64_t relay = 0, mode = 0, setting = 0;
+  uint8_t outputs = 0;
+};
+
+struct Connection
+{
+  int socket = -1;
+  std::string received = "";
+  int32_t device = -1; // set by the upgrade
+};
+
+struct Latencies
+{
+  const char *name = "";
+  std::vector<uint64_t> nanos = {};
+  uint32_t lost = 0;
+};
+
+static bool sendAll(int socket, const std::string &data)
+{
+  for (size_t sent = 0; sent < data.size();)
+  {
+    ssize_t n = send(socket, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+    if (n <= 0)
+      return false;
+    sent += n;
+  }
+  return true;
+}
+
+// the upgrade: "apikey:key<n>" in the Basic authorization names device n
+static int32_t upgrade(Connection &connection, uint32_t devices)
+{
+  size_t end = connection.received.find("\r\n\r\n");
+  if (end == std::string::npos)
+    return -1;
+  std::string head = connection.received.substr(0, end + 2);
+  connection.received.erase(0, end + 4);
+  std::string authorization = WebSockets::header(head, "Authorization");
+  std::string credentials = authorization.compare(0, 6, "Basic ") == 0 ? WebSockets::base64Decode(authorization.substr(6)) : "";
+  uint32_t index = 0;
+  if (sscanf(credentials.c_str(), "apikey:key%u", &index) != 1 || index >= devices)
+  {
+    sendAll(connection.socket, "HTTP/1.1 401 Unauthorized\r\nContent-Length: 0\r\n\r\n");
+    return -2;
+  }
+  std::string answer = "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Accept: " +
+                       WebSockets::acceptKey(WebSockets::header(head, "Sec-WebSocket-Key")) + "\r\nSec-WebSocket-Protocol: arduino\r\n\r\n";
+  return sendAll(connection.socket, answer) ? (int32_t)index : -2;
+}
+
+static void print(Latencies &latencies)
+{
+  std::vector<uint64_t> &sorted = latencies.nanos;
+  std::sort(sorted.begin(), sorted.end());
+  auto at = [&](double p) { return sorted.empty() ? 0 : sorted[std::min(sorted.size() - 1, (size_t)(sorted.size() * p))] / 1e6; };
+  printf("%-34s %8zu %8.2f %8.2f %8.2f %8.2f %6u\n", latencies.name, sorted.size(), at(0.5), at(0.9), at(0.99), sorted.empty() ? 0 : sorted.back() / 1e6,
+         latencies.lost);
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t devices = 8, seconds = 10, rate = 2;
+  for (int i = 1; i + 1 < argc; i += 2)
+  {
+    if (strcmp(argv[i], "-d") == 0)
+      devices = max(1, atoi(argv[i + 1]));
+    else if (strcmp(argv[i], "-s") == 0)
+      seconds = max(1, atoi(argv[i + 1]));
+    else if (strcmp(argv[i], "-r") == 0)
+      rate = max(1, atoi(argv[i + 1]));
+  }
+
+  int listener = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t length = sizeof(address);
+  if (listener < 0 || bind(listener, (sockaddr *)&address, sizeof(address)) != 0 || listen(listener, 128) != 0 ||
+      getsockname(listener, (sockaddr *)&address, &length) != 0)
+  {
+    perror("bench_cloud: listen");
+    return 1;
+  }
+  int reports[2];
+  if (pipe(reports) != 0)
+  {
+    perror("bench_cloud: pipe");
+    return 1;
+  }
+
+  std::vector<pid_t> children;
+  for (uint32_t i = 0; i < devices; i++)
+  {
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+      close(listener);
+      close(reports[0]);
+      device(i, ntohs(address.sin_port), reports[1]);
+    }
+    children.push_back(pid);
+  }
+  close(reports[1]);
+
+  std::vector<Connection> connections;
+  std::vector<Pending> pending(devices);
+  std::vector<bool> online(devices, false);
+  std::vector<uint32_t> sent(devices, 0);
+  Latencies relay = {"mode -> relay"}, modeFrame = {"mode -> SetThermostatMode"}, settingFrame = {"setpoint -> SetTemperatureSetting"};
+  std::map<std::string, std::pair<uint64_t, uint64_t>> telemetry; // action: frames, bytes
+  uint32_t connected = 0, reconnects = 0, commands = 0;
+  uint64_t start = 0, deadline = nanos() + (uint64_t)CONNECT_TIMEOUT * 1000000000, period = 1000000000 / rate;
+  uint64_t nextRound = 0;
+  bool measuring = false;
+
+  while (nanos() < deadline)
+  {
+    std::vector<pollfd> fds = {{listener, POLLIN, 0}, {reports[0], POLLIN, 0}};
+    for (Connection &connection : connections)
+      fds.push_back({connection.socket, POLLIN, 0});
+    poll(fds.data(), fds.size(), 1);
+    uint64_t now = nanos();
+
+    if (fds[0].revents & POLLIN)
+    {
+      int socket = accept(listener, NULL, NULL);
+      int one = 1;
+      setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+      connections.push_back({socket});
+    }
+
+    if (fds[1].revents & POLLIN)
+    {
+      RelayReport report;
+      if (read(reports[0], &report, sizeof(report)) == sizeof(report) && measuring)
+      {
+        Pending &owed = pending[report.device];
+        if (owed.relay != 0 && report.outputs == owed.outputs)
+        {
+          relay.nanos.push_back(report.at - owed.relay);
+          owed.relay = 0;
+        }
+      }
+    }
+
+    for (size_t i = 2; i < fds.size(); i++)
+    {
+      if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR)))
+        continue;
+      Connection &connection = connections[i - 2];
+      char buffer[4096];
+      ssize_t n = recv(connection.socket, buffer, sizeof(buffer), 0);
+      if (n <= 0)
+      {
+        if (connection.device >= 0)
+          online[connection.device] = false;
+        close(connection.socket);
+        connection.socket = -1;
+        continue;
+      }
+      connection.received.append(buffer, n);
+      if (connection.device < 0)
+      {
+        int32_t device = upgrade(connection, devices);
+        if (device == -2)
+        {
+          close(connection.socket);
+          connection.socket = -1;
+          continue;
+        }
+        if (device < 0)
+          continue;
+        connection.device = device;
+        connected += !online[device];
+        reconnects += measuring;
+        online[device] = true;
+      }
+
+      WebSockets::Opcode opcode;
+      std::string payload;
+      while (connection.socket >= 0 && WebSockets::parse(connection.received, opcode, payload))
+      {
+        if (opcode == WebSockets::CLOSE)
+        {
+          online[connection.device] = false;
+          close(connection.socket);
+          connection.socket = -1;
+        }
+        if (opcode != WebSockets::TEXT || !measuring)
+          continue;
+        JsonView frame = {payload.data(), payload.size()}, action;
+        if (!ThermostatCommand::field(frame, "action", action))
+          continue;
+        std::string name(action.data, action.length);
+        telemetry[name].first++;
+        telemetry[name].second += payload.size();
+        Pending &owed = pending[connection.device];
+        uint64_t *since = name == "SetThermostatMode" ? &owed.mode : name == "SetTemperatureSetting" ? &owed.setting : NULL;
+        if (since != NULL && *since != 0)
+        {
+          (name == "SetThermostatMode" ? modeFrame : settingFrame).nanos.push_back(now - *since);
+          *since = 0;
+        }
+      }
+    }
+    connections.erase(std::remove_if(connections.begin(), connections.end(), [](const Connection &c) { return c.socket < 0; }), connections.end());
+
+    // everyone online: the measured window starts
+    if (!measuring && connected == devices)
+    {
+      measuring = true;
+      start = nextRound = now;
+      deadline = now + (uint64_t)seconds * 1000000000;
+    }
+    if (!measuring || now < nextRound)
+      continue;
+
+    // a round of commands, one per device: fan, a setpoint, off, a setpoint
+    nextRound += period;
+    for (Connection &connection : connections)
+    {
+      if (connection.device < 0)
+        continue;
+      uint32_t n = sent[connection.device]++;
+      Pending &owed = pending[connection.device];
+      char text[256];
+      if (n % 2 == 0)
+      {
+        bool fan = n % 4 == 0;
+        snprintf(text, sizeof(text), "{\"deviceId\":\"dev%d\",\"action\":\"action.devices.commands.ThermostatSetMode\",\"value\":{\"thermostatMode\":\"%s\"}}",
+                 connection.device, fan ? "fan" : "off");
+        relay.lost += owed.relay != 0;
+        modeFrame.lost += owed.mode != 0;
+        owed.outputs = fan ? RELAY_FAN : 0;
+        owed.relay = owed.mode = nanos();
+      }
+      else
+      {
+        snprintf(text, sizeof(text), "{\"deviceId\":\"dev%d\",\"action\":\"action.devices.commands.ThermostatTemperatureSetpoint\",\"value\":{\"thermostatTemperatureSetpoint\":%d}}",
+                 connection.device, n % 4 == 1 ? 24 : 20);
+        settingFrame.lost += owed.setting != 0;
+        owed.setting = nanos();
+      }
+      std::string frame = WebSockets::frame(WebSockets::TEXT, text, strlen(text), false);
+      commands += sendAll(connection.socket, frame);
+    }
+  }
+
+  for (pid_t pid : children)
+    kill(pid, SIGTERM);
+  for (pid_t pid : children)
+    waitpid(pid, NULL, 0);
+  if (!measuring)
+  {
+    fprintf(stderr, "bench_cloud: %u of %u devices came online\n", connected, devices);
+    return 1;
+  }
+
+  double elapsed = (nanos() - start) / 1e9;
+  printf("%u devices, %u commands in %.1f s, %u reconnects\n\n", devices, commands, elapsed, reconnects);
+  printf("%-34s %8s %8s %8s %8s %8s %6s\n", "latency", "count", "p50 ms", "p90 ms", "p99 ms", "max ms", "lost");
+  print(relay);
+  print(modeFrame);
+  print(settingFrame);
+  printf("\n%-34s %8s %10s %10s\n", "telemetry", "frames", "frames/s", "bytes/s");
+  for (const auto &action : telemetry)
+    printf("%-34s %8llu %10.1f %10.1f\n", action.first.c_str(), (unsigned long long)action.second.first, action.second.first / elapsed,
+           action.second.second / elapsed);
+  return 0;
+}
@@ -0,0 +1,125 @@
+// Per-command cost of ThermostatCommand::dispatch() over recorded Sinric
+// frames, one per line: the sketch's own action table and handlers, the
+// sketch's device id. Frames are grouped by what happens to them, each
+// group replayed until it has run at least the given number of frames;
+// time per frame is the best of ROUNDS, with the heap traffic it caused.
+//
+//   bench_commands [frames.txt] [frames per group]
+#include <Arduino.h>
+#include <Host.h>
+#include "Thermostat.h"
+#include "ThermostatCommand.h"
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#define ROUNDS 5
+#define DEVICE "5f1d8e2a9c3b4e0012ab34cd"
+
+static volatile float point;
+static volatile ThermostatState state;
+static volatile uint32_t tests;
+
+// the handlers of Thermostat.ino, storing into locals instead of data
+static void onSetpointCommand(const JsonView &value)
+{
+  JsonView field;
+  if (ThermostatCommand::field(value, "thermostatTemperatureSetpoint", field))
+    point = field.toFloat();
+}
+
+static void onSetModeCommand(const JsonView &value)
+{
+  JsonView mode;
+  char text[8];
+  if (!ThermostatCommand::field(value, "thermostatMode", mode))
+    return;
+  mode.copy(text, sizeof(text));
+  state = Thermostat::strToState(text);
+}
+
+static void onTestCommand(const JsonView &value) { tests++; }
+
+static const ThermostatCommand::Action commands[] = {
+    {ThermostatCommand::hash("action.devices.commands.ThermostatTemperatureSetpoint"), onSetpointCommand},
+    {ThermostatCommand::hash("action.devices.commands.ThermostatSetMode"), onSetModeCommand},
+    {ThermostatCommand::hash("test"), onTestCommand},
+};
+
+// what a frame is: its action, or why it never reaches one
+static std::string classify(const std::string &frame)
+{
+  JsonView whole = {frame.data(), frame.size()}, device, action;
+  if (!ThermostatCommand::field(whole, "action", action))
+    return "(no action)";
+  if (!ThermostatCommand::field(whole, "deviceId", device) || !device.equals(DEVICE))
+    return "(other device)";
+  std::string name(action.data, action.length);
+  size_t dot = name.rfind('.');
+  return dot == std::string::npos ? name : name.substr(dot + 1);
+}
+
+static void measure(const std::string &name, const std::vector<std::string> &frames, uint32_t count)
+{
+  uint32_t passes = max(1u, (count + (uint32_t)frames.size() - 1) / (uint32_t)frames.size());
+  uint32_t dispatched = 0, total = passes * frames.size();
+  size_t bytes = 0;
+  for (const std::string &frame : frames)
+    bytes += frame.size();
+
+  double best = 0;
+  for (int round = 0; round < ROUNDS; round++)
+  {
+    dispatched = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t pass = 0; pass < passes; pass++)
+      for (const std::string &frame : frames)
+        dispatched += ThermostatCommand::dispatch(frame.data(), frame.size(), DEVICE, commands, sizeof(commands) / sizeof(commands[0]));
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / total;
+    if (round == 0 || ns < best)
+      best = ns;
+  }
+
+  uint32_t allocationsBefore = Host::getAllocations();
+  for (const std::string &frame : frames)
+    ThermostatCommand::dispatch(frame.data(), frame.size(), DEVICE, commands, sizeof(commands) / sizeof(commands[0]));
+  uint32_t allocations = Host::getAllocations() - allocationsBefore;
+
+  printf("%-30s %6zu %8.1f %9.1f %8.2f %9.3f %8.1f\n", name.c_str(), frames.size(), (double)bytes / frames.size(), best,
+         best * frames.size() / bytes, (double)allocations / frames.size(), 100.0 * dispatched / total);
+}
+
+int main(int argc, char **argv)
+{
+  const char *path = argc > 1 ? argv[1] : SINRIC_FRAMES;
+  uint32_t count = argc > 2 ? strtoul(argv[2], NULL, 10) : 1000000;
+  std::ifstream file(path);
+  if (!file)
+  {
+    fprintf(stderr, "bench_commands: cannot read %s\n", path);
+    return 1;
+  }
+
+  std::map<std::string, std::vector<std::string>> groups;
+  std::vector<std::string> all;
+  for (std::string line; std::getline(file, line);)
+  {
+    if (line.empty())
+      continue;
+    groups[classify(line)].push_back(line);
+    all.push_back(line);
+  }
+  if (all.empty())
+  {
+    fprintf(stderr, "bench_commands: no frames in %s\n", path);
+    return 1;
+  }
+
+  printf("%-30s %6s %8s %9s %8s %9s %8s\n", "command", "frames", "bytes", "ns/frame", "ns/byte", "allocs", "handled%");
+  for (const auto &group : groups)
+    measure(group.first, group.second, count);
+  measure("(all)", all, count);
+  return 0;
+}
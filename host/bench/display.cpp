@@ -0,0 +1,121 @@
+// Frame composition cost of the main screen: ThermostatDisplay::loop(),
+// which blits the pre-rasterized glyphs, against the GFX text path it
+// replaced (setTextSize/setCursor/print of String numbers, copied here
+// from the history of ThermostatDisplay.cpp). Both draw into the same
+// SSD1306 buffer on the fake core, pixel by pixel for GFX; the glyph
+// figures also include commit()'s diff against the front buffer, which
+// the GFX path did not have. Nothing is sent to the panel.
+//
+//   bench_display [frames]
+#include <Arduino.h>
+#include <Host.h>
+#include "ThermostatDisplay.h"
+#include <chrono>
+
+#define ROUNDS 5
+#define SCREENS 256
+
+struct Screen
+{
+  ThermostatState state;
+  int point;
+  float temperature, humidity;
+};
+
+static Screen screens[SCREENS];
+
+// the old loop() body, text sizes truncated to the integers GFX kept
+static void gfx(Adafruit_SSD1306 *display, const Screen &screen, const char *wifi)
+{
+  display->clearDisplay();
+  display->setCursor(0, 0);
+  display->setTextColor(SSD1306_WHITE);
+  display->setTextSize(1);
+  display->print("WiFi:");
+  display->println(wifi);
+  display->setCursor(0, 12);
+  display->setTextSize(3);
+  String ty = "";
+  switch (screen.state)
+  {
+  case COOL:
+    ty = " CL ";
+    // fall through
+  case HEAT:
+    display->print(String((float)screen.point, 0));
+    display->setTextSize(1);
+    display->print((char)247);
+    display->println("C");
+    display->setCursor(38, 24);
+    display->setTextColor(SSD1306_BLACK, SSD1306_WHITE);
+    display->println(ty.isEmpty() ? " HT " : ty);
+    break;
+  case FAN:
+    display->print("FAN");
+    break;
+  default:
+    break;
+  }
+  display->setTextColor(SSD1306_WHITE);
+  int x = 70;
+  display->setTextSize(1);
+  display->setCursor(x, 13);
+  display->print(String(screen.temperature, 1));
+  display->print((char)247);
+  display->println("C");
+  display->setCursor(x, 24);
+  display->print(String(screen.humidity, 0));
+  display->print("%");
+}
+
+static void glyphs(ThermostatDisplay &display, const Screen &screen)
+{
+  display.setThermState(screen.state);
+  display.setPoint(screen.point);
+  display.setTemperature(screen.temperature);
+  display.setHumidity(screen.humidity);
+  display.loop();
+}
+
+template <class F>
+static void measure(const char *name, uint32_t frames, F compose)
+{
+  double best = 0;
+  for (int round = 0; round < ROUNDS; round++)
+  {
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < frames; i++)
+      compose(screens[i % SCREENS]);
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / frames;
+    if (round == 0 || ns < best)
+      best = ns;
+  }
+  uint32_t allocationsBefore = Host::getAllocations();
+  uint64_t bytesBefore = Host::getAllocatedBytes();
+  for (uint32_t i = 0; i < SCREENS; i++)
+    compose(screens[i]);
+  printf("%-8s %9u %10.2f %9.3f %9.1f\n", name, frames, best / 1000, (double)(Host::getAllocations() - allocationsBefore) / SCREENS,
+         (double)(Host::getAllocatedBytes() - bytesBefore) / SCREENS);
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t frames = argc > 1 ? strtoul(argv[1], NULL, 10) : 100000;
+  static const ThermostatState states[] = {HEAT, COOL, FAN, OFF};
+  for (int i = 0; i < SCREENS; i++)
+    screens[i] = {states[i % 4], 16 + i % 15, i % 31 == 0 ? NAN : 15 + (i % 150) / 10.0f, 30.0f + i % 41};
+
+  Host::attachPanel(OLED_ADDRESS);
+  ThermostatDisplay display;
+  if (!display.begin())
+  {
+    fprintf(stderr, "bench_display: no panel\n");
+    return 1;
+  }
+  display.setWifi("home");
+
+  printf("%-8s %9s %10s %9s %9s\n", "path", "frames", "us/frame", "allocs", "heap B");
+  measure("glyphs", frames, [&](const Screen &screen) { glyphs(display, screen); });
+  measure("gfx", frames, [&](const Screen &screen) { gfx(display.display, screen, "home"); });
+  return 0;
+}
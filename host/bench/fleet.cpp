@@ -0,0 +1,180 @@
+// A fleet of simulated thermostats: every instance is a BasicThermostat
+// driving a ThermostatSimulation room on its own virtual clock, with the
+// sketch's cycle settings. The fleet sweeps setpoints and hysteresis
+// bands; each setting runs the same set of rooms (outdoor temperature and
+// time constant drawn from a seed per room), heating or cooling toward
+// the point. Rooms are spread over worker threads, each with its own
+// deque: a worker takes its newest room, and once it runs dry it steals
+// the oldest room of another worker.
+//
+// Per setting: compressor cycles and relay transitions per hour, mean
+// comfort error, energy per room and day, and compressor duty. Then the
+// wall time and simulated room-hours per second.
+//
+//   bench_fleet [-n rooms] [-h hours] [-j threads]
+#include <Arduino.h>
+#include "Thermostat.h"
+#include "ThermostatSimulation.h"
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#define TICK 5000 // ms of virtual time between runner() calls
+
+static const float points[] = {19, 21, 23, 25};
+static const float bands[] = {0.25, 0.5, 1.0, 2.0};
+#define POINTS (sizeof(points) / sizeof(points[0]))
+#define BANDS (sizeof(bands) / sizeof(bands[0]))
+
+struct Room
+{
+  uint16_t setting; // index into points x bands
+  uint32_t seed;
+};
+
+struct Result
+{
+  uint32_t cycles, transitions;
+  uint64_t compressorMillis;
+  double comfortError, energy;
+};
+
+static Result simulate(const Room &room, uint64_t duration)
+{
+  std::mt19937 random(room.seed);
+  float point = points[room.setting / BANDS], band = bands[room.setting % BANDS];
+  // half the rooms in a cold climate, half in a hot one
+  bool cold = room.seed % 2 == 0;
+  float outdoor = cold ? std::uniform_real_distribution<float>(5, 15)(random) : std::uniform_real_distribution<float>(28, 34)(random);
+  unsigned long tau = std::uniform_int_distribution<unsigned long>(1800000, 7200000)(random);
+  ThermostatState state = cold ? HEAT : COOL;
+
+  ThermostatSimulation simulation(point + std::uniform_real_distribution<float>(-3, 3)(random));
+  simulation.setOutdoor(outdoor);
+  simulation.setTimeConstant(tau);
+  BasicThermostat<ThermostatNoHooks> thermostat;
+  thermostat.setHysteresis(band);
+  thermostat.setMinOnTime(180000);
+  thermostat.setMinOffTime(180000);
+  thermostat.setFanOverrun(30000);
+
+  for (uint64_t now = 0; now <= duration; now += TICK)
+  {
+    simulation.step(thermostat.getRelays()->getOutputs(), state, point, now);
+    thermostat.runner(state, point, simulation.getTemperature(), (unsigned long)now);
+  }
+  return {thermostat.getCycles(), thermostat.getTransitions(), simulation.getCompressorMillis(), simulation.getComfortError(), simulation.getEnergy()};
+}
+
+// a worker's rooms: the owner pops at the back, thieves take the front
+struct Worker
+{
+  std::mutex lock;
+  std::deque<uint32_t> rooms;
+  uint32_t stolen = 0;
+
+  bool pop(uint32_t &room)
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    if (rooms.empty())
+      return false;
+    room = rooms.back();
+    rooms.pop_back();
+    return true;
+  }
+
+  bool steal(uint32_t &room)
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    if (rooms.empty())
+      return false;
+    room = rooms.front();
+    rooms.pop_front();
+    return true;
+  }
+};
+
+static void work(std::vector<Worker> &workers, size_t self, const std::vector<Room> &rooms, std::vector<Result> &results, uint64_t duration)
+{
+  Worker &worker = workers[self];
+  uint32_t room;
+  for (;;)
+  {
+    if (!worker.pop(room))
+    {
+      bool found = false;
+      for (size_t i = 1; i < workers.size() && !found; i++)
+        found = workers[(self + i) % workers.size()].steal(room);
+      if (!found)
+        return; // nothing is ever pushed back, so every deque is empty
+      worker.stolen++;
+    }
+    results[room] = simulate(rooms[room], duration);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t perSetting = 64, hours = 24;
+  unsigned threads = max(1u, std::thread::hardware_concurrency());
+  for (int i = 1; i + 1 < argc; i += 2)
+  {
+    if (strcmp(argv[i], "-n") == 0)
+      perSetting = max(1, atoi(argv[i + 1]));
+    else if (strcmp(argv[i], "-h") == 0)
+      hours = max(1, atoi(argv[i + 1]));
+    else if (strcmp(argv[i], "-j") == 0)
+      threads = max(1, atoi(argv[i + 1]));
+  }
+  uint64_t duration = (uint64_t)hours * 3600000;
+
+  // every setting sees the same seeds, so settings compare on equal rooms
+  std::vector<Room> rooms;
+  for (uint16_t setting = 0; setting < POINTS * BANDS; setting++)
+    for (uint32_t i = 0; i < perSetting; i++)
+      rooms.push_back({setting, 0x9E3779B9u * (i + 1)});
+  std::vector<Result> results(rooms.size());
+
+  // dealt out in runs, so a setting's rooms start on the same worker and
+  // the stealing does the balancing
+  std::vector<Worker> workers(threads);
+  for (uint32_t i = 0; i < rooms.size(); i++)
+    workers[(uint64_t)i * threads / rooms.size()].rooms.push_back(i);
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> pool;
+  for (size_t i = 0; i < threads; i++)
+    pool.emplace_back(work, std::ref(workers), i, std::cref(rooms), std::ref(results), duration);
+  for (std::thread &thread : pool)
+    thread.join();
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  printf("%6s %5s %6s %10s %12s %9s %10s %7s\n", "point", "band", "rooms", "cycles/h", "switches/h", "error C", "Wh/day", "duty%");
+  for (uint16_t setting = 0; setting < POINTS * BANDS; setting++)
+  {
+    double cycles = 0, transitions = 0, error = 0, energy = 0, compressor = 0;
+    for (uint32_t i = 0; i < rooms.size(); i++)
+    {
+      if (rooms[i].setting != setting)
+        continue;
+      cycles += results[i].cycles;
+      transitions += results[i].transitions;
+      error += results[i].comfortError;
+      energy += results[i].energy;
+      compressor += results[i].compressorMillis;
+    }
+    printf("%6.1f %5.2f %6u %10.2f %12.2f %9.3f %10.1f %7.1f\n", points[setting / BANDS], bands[setting % BANDS], perSetting,
+           cycles / perSetting / hours, transitions / perSetting / hours, error / perSetting, energy / perSetting * 24 / hours,
+           100.0 * compressor / perSetting / duration);
+  }
+
+  uint32_t stolen = 0;
+  for (Worker &worker : workers)
+    stolen += worker.stolen;
+  printf("\n%zu rooms x %u h on %u threads in %.2f s: %.0f room-hours/s, %u rooms stolen\n", rooms.size(), hours, threads, seconds,
+         rooms.size() * hours / seconds, stolen);
+  return 0;
+}
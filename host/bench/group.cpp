@@ -0,0 +1,60 @@
+// ThermostatGroup::update() from 1 to 10,000 zones: the cost per zone
+// should stay flat as the group grows. Every zone drifts through its
+// setpoint, so relays switch and zones report changes along the way.
+//
+//   bench_group [ticks]
+#include <Arduino.h>
+#include "ThermostatGroup.h"
+#include <chrono>
+#include <memory>
+
+static uint32_t reported;
+
+template <size_t N>
+static void run(uint32_t ticks)
+{
+  std::unique_ptr<ThermostatGroup<N>> group(new ThermostatGroup<N>());
+  for (size_t i = 0; i < N; i++)
+    group->addZone(3 * i % 240, (3 * i + 1) % 240, (3 * i + 2) % 240);
+  group->setHysteresis(1.0);
+  group->setMinOnTime(180000);
+  group->setMinOffTime(180000);
+  group->setFanOverrun(30000);
+  group->setOnZoneChange([](uint16_t zone, uint8_t changes) { reported++; });
+  group->begin();
+  for (uint16_t i = 0; i < N; i++)
+  {
+    group->setState(i, i % 3 == 0 ? COOL : HEAT);
+    group->setPoint(i, 20 + i % 4);
+  }
+
+  reported = 0;
+  unsigned long now = 0;
+  double ns = 0;
+  // a reading every 2 s per zone, an update() every 100 ms
+  for (uint32_t tick = 0; tick < ticks; tick++, now += 100)
+  {
+    if (tick % 20 == 0)
+      for (uint16_t i = 0; i < N; i++)
+        group->setTemperature(i, 22 + 4 * sinf((tick / 20 + i) * 0.05f));
+    auto start = std::chrono::steady_clock::now();
+    group->update(now);
+    ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  }
+  uint64_t cycles = 0;
+  for (uint16_t i = 0; i < N; i++)
+    cycles += group->getCycles(i);
+  printf("%6zu %8u %12.1f %9.2f %10.2f %9.3f\n", N, ticks, ns / ticks, ns / ticks / N, (double)reported / ticks, (double)cycles / N);
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t ticks = argc > 1 ? strtoul(argv[1], NULL, 10) : 20000;
+  printf("%6s %8s %12s %9s %10s %9s\n", "zones", "ticks", "ns/update", "ns/zone", "reports", "cycles");
+  run<1>(ticks * 100);
+  run<10>(ticks * 10);
+  run<100>(ticks);
+  run<1000>(ticks);
+  run<10000>(ticks / 10);
+  return 0;
+}
@@ -0,0 +1,181 @@
+// Decode time per IR frame over a corpus of Mirage frames: every
+// temperature, mode, speed and tab byte the remote sends, with one frame
+// in eight from another protocol. Three paths see the same corpus:
+//
+//   tables   the per-protocol lookup tables ThermostatIRCtrls uses now
+//   strings  the decoding it replaced: typeToString() compared with
+//            "MIRAGE", uint64ToString() of the mode byte, a switch per
+//            temperature (copied here from the history of the file)
+//   loop     ThermostatIRCtrls::loop() end to end, frames queued on the
+//            fake receiver, callbacks included
+//
+//   bench_ir [passes]
+#include <Arduino.h>
+#include <Host.h>
+#include "ThermostatIRCtrls.h"
+#include <chrono>
+#include <vector>
+
+#define ROUNDS 5
+
+static const uint8_t tabs[] = {0xC0, 0x1A, 0x16, 0x12, 0x0E, 0x0A, 0x06};
+static volatile int sink; // keeps the decoded settings observable
+
+static std::vector<decode_results> corpus()
+{
+  std::vector<decode_results> frames;
+  for (uint8_t temp = 0x6C; temp <= 0x7C; temp++)
+    for (uint8_t mode = 1; mode <= 5; mode++)
+      for (uint8_t speed = 0; speed < 8; speed++)
+        for (uint8_t tab : tabs)
+        {
+          decode_results results = {};
+          results.decode_type = frames.size() % 8 == 7 ? (frames.size() % 16 == 7 ? NEC : COOLIX) : MIRAGE;
+          results.bits = results.decode_type == MIRAGE ? 120 : 32;
+          results.state[1] = temp;
+          results.state[4] = mode << 4 | speed;
+          results.state[5] = tab;
+          frames.push_back(results);
+        }
+  return frames;
+}
+
+// the protected decoding steps, old and new, on one results struct
+class Decoder : public ThermostatIRCtrls
+{
+public:
+  int tables(const decode_results *results)
+  {
+    const Protocol *protocol = getProtocol(results->decode_type);
+    if (protocol == NULL)
+      return 0;
+    return getSpeed(protocol, results) + getTemp(protocol, results) + getMode(protocol, results) + getTab(protocol, results);
+  }
+
+  int strings(const decode_results *results)
+  {
+    if (typeToString(results->decode_type, results->repeat) != "MIRAGE")
+      return 0;
+    return stringSpeed(results) + stringTemp(results) + stringMode(results) + (TCTab)results->state[5];
+  }
+
+private:
+  static TCMode stringMode(const decode_results *results)
+  {
+    String state = uint64ToString(results->state[4], 16);
+    return (TCMode)state.c_str()[0];
+  }
+
+  // the old switch fell off its end for a one digit byte; AUTO1 here
+  static TCSpeed stringSpeed(const decode_results *results)
+  {
+    String state = uint64ToString(results->state[4], 16);
+    switch (state.c_str()[1])
+    {
+    case '6':
+    case '2':
+      return SPEED1;
+    case '7':
+    case '3':
+      return SPEED2;
+    case '5':
+    case '1':
+      return SPEED3;
+    default:
+      return AUTO1;
+    }
+  }
+
+  static int stringTemp(const decode_results *results)
+  {
+    switch (results->state[1])
+    {
+    case 0x6C: return 16;
+    case 0x6D: return 17;
+    case 0x6E: return 18;
+    case 0x6F: return 19;
+    case 0x70: return 20;
+    case 0x71: return 21;
+    case 0x72: return 22;
+    case 0x73: return 23;
+    case 0x74: return 24;
+    case 0x75: return 25;
+    case 0x76: return 26;
+    case 0x77: return 27;
+    case 0x78: return 28;
+    case 0x79: return 29;
+    case 0x7A: return 30;
+    case 0x7B: return 31;
+    case 0x7C: return 32;
+    }
+    return 0;
+  }
+};
+
+static void report(const char *name, size_t frames, double ns, uint32_t allocations)
+{
+  printf("%-8s %8zu %9.1f %9.3f\n", name, frames, ns, (double)allocations / frames);
+}
+
+template <class F>
+static void measure(const char *name, const std::vector<decode_results> &frames, uint32_t passes, F decode)
+{
+  double best = 0;
+  for (int round = 0; round < ROUNDS; round++)
+  {
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t pass = 0; pass < passes; pass++)
+      for (const decode_results &results : frames)
+        sink += decode(&results);
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (passes * frames.size());
+    if (round == 0 || ns < best)
+      best = ns;
+  }
+  uint32_t allocationsBefore = Host::getAllocations();
+  for (const decode_results &results : frames)
+    sink += decode(&results);
+  report(name, frames.size(), best, Host::getAllocations() - allocationsBefore);
+}
+
+// the fake receiver hands out one queued frame per decode(), as the
+// sketch's loop() sees them
+static void measureLoop(const std::vector<decode_results> &frames, uint32_t passes)
+{
+  ThermostatIRCtrls ir;
+  ir.begin();
+  ir.setOnChange([](ThermostatIRCtrls::TCSpeed speed, ThermostatIRCtrls::TCTab tab, ThermostatIRCtrls::TCMode mode, int temp) { sink += temp; });
+  double best = 0;
+  uint32_t allocations = 0;
+  for (int round = 0; round < ROUNDS; round++)
+  {
+    double ns = 0;
+    for (uint32_t pass = 0; pass < passes; pass++)
+    {
+      for (const decode_results &results : frames)
+        Host::sendIR(results);
+      uint32_t allocationsBefore = Host::getAllocations();
+      auto start = std::chrono::steady_clock::now();
+      for (size_t i = 0; i < frames.size(); i++)
+        ir.loop();
+      ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+      if (round == 0 && pass == 0)
+        allocations = Host::getAllocations() - allocationsBefore;
+    }
+    ns /= passes * frames.size();
+    if (round == 0 || ns < best)
+      best = ns;
+  }
+  report("loop", frames.size(), best, allocations);
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t passes = argc > 1 ? strtoul(argv[1], NULL, 10) : 200;
+  std::vector<decode_results> frames = corpus();
+  Decoder decoder;
+  printf("%-8s %8s %9s %9s\n", "path", "frames", "ns/frame", "allocs");
+  measure("tables", frames, passes, [&](const decode_results *results) { return decoder.tables(results); });
+  measure("strings", frames, passes, [&](const decode_results *results) { return decoder.strings(results); });
+  measureLoop(frames, passes);
+  return 0;
+}
@@ -0,0 +1,185 @@
+// Per-loop() cost of Thermostat.ino under scripted scenarios: wall time of
+// every pass on this machine (p50/p90/p99/max) and the heap traffic it
+// caused. The virtual clock moves 1 ms between passes, so the sketch sees
+// the same timeline on every run; each scenario boots in its own process.
+//
+//   bench_loop [scenario ...] [-s seconds]
+#include <Arduino.h>
+#include <Host.h>
+#include <IRrecv.h>
+#include <chrono>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#define PIN_BTN D3
+#define PIN_DHT D9
+#define WARMUP 5000 // ms after boot left out of the figures
+
+void setup();
+void loop();
+
+struct Scenario
+{
+  const char *name, *description;
+  void (*step)(uint32_t ms); // before the pass at virtual time ms
+};
+
+static void command(const char *action, const char *value)
+{
+  char frame[256];
+  snprintf(frame, sizeof(frame), "{\"deviceId\":\"dev1\",\"action\":\"%s\",\"value\":%s}", action, value);
+  Host::cloudSend(frame);
+}
+
+static void idle(uint32_t ms) {}
+
+// a room drifting 16..28 C over ten minutes: relays cycle, telemetry flows
+static void heating(uint32_t ms)
+{
+  if (ms == WARMUP)
+    command("action.devices.commands.ThermostatSetMode", "{\"thermostatMode\":\"heat\"}");
+  if (ms % 10000 == 0)
+  {
+    uint32_t phase = ms % 600000;
+    float t = phase < 300000 ? 16 + phase / 25000.0f : 28 - (phase - 300000) / 25000.0f;
+    Host::setDHT(t, 45);
+  }
+}
+
+// a command every 100 ms, setpoints and modes alternating
+static void cloud(uint32_t ms)
+{
+  if (ms % 100 != 0)
+    return;
+  static const char *modes[] = {"{\"thermostatMode\":\"heat\"}", "{\"thermostatMode\":\"cool\"}", "{\"thermostatMode\":\"fan\"}", "{\"thermostatMode\":\"off\"}"};
+  char point[64];
+  uint32_t n = ms / 100;
+  if (n % 2)
+  {
+    snprintf(point, sizeof(point), "{\"thermostatTemperatureSetpoint\":%u}", 16 + n % 15);
+    command("action.devices.commands.ThermostatTemperatureSetpoint", point);
+  }
+  else
+    command("action.devices.commands.ThermostatSetMode", modes[(n / 2) % 4]);
+}
+
+// a Mirage remote every 500 ms and the flash button (active low) tapped
+// every second
+static void inputs(uint32_t ms)
+{
+  if (ms % 500 == 0)
+  {
+    decode_results results = {};
+    results.decode_type = MIRAGE;
+    results.bits = 120;
+    results.state[1] = (ms / 500) % 2;
+    results.state[4] = ((ms / 1000) % 4) << 4 | (ms / 500) % 4;
+    results.state[5] = 0x6C + (ms / 500) % 17;
+    Host::sendIR(results);
+  }
+  if (ms % 1000 == 0)
+  {
+    Host::schedule(Host::getMicros() + 200, PIN_BTN, LOW);
+    Host::schedule(Host::getMicros() + 80000, PIN_BTN, HIGH);
+  }
+}
+
+// the station drops every 30 s and comes back 5 s later
+static void flapping(uint32_t ms)
+{
+  if (ms % 30000 == 0)
+    Host::wifiDisconnect();
+  else if (ms % 30000 == 5000)
+    Host::wifiConnect("home");
+}
+
+static const Scenario scenarios[] = {
+    {"idle", "cloud up, steady room, no input", idle},
+    {"heating", "room drifting through the setpoint", heating},
+    {"cloud", "a Sinric command every 100 ms", cloud},
+    {"inputs", "IR frames and button presses", inputs},
+    {"flapping", "WiFi lost every 30 s", flapping},
+};
+
+static uint64_t percentile(std::vector<uint64_t> &sorted, double p)
+{
+  return sorted[std::min(sorted.size() - 1, (size_t)(sorted.size() * p))];
+}
+
+static void run(const Scenario &scenario, uint32_t seconds)
+{
+  Host::attachDHT(PIN_DHT, 11);
+  Host::setDHT(21, 45);
+  Host::attachPanel(0x3C);
+  setup();
+  // first boot: the portal page is saved with the network and Sinric keys
+  Host::submitPortal("home", {{"sinric_apiKey", "key"}, {"sinric_devId", "dev1"}});
+
+  std::vector<uint64_t> nanos;
+  nanos.reserve(seconds * 1000);
+  uint64_t allocations = 0, bytes = 0, maxAllocations = 0;
+  for (uint32_t ms = 0; ms < WARMUP + seconds * 1000; ms++)
+  {
+    scenario.step(ms);
+    uint32_t allocationsBefore = Host::getAllocations();
+    uint64_t bytesBefore = Host::getAllocatedBytes();
+    auto start = std::chrono::steady_clock::now();
+    loop();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    uint32_t passAllocations = Host::getAllocations() - allocationsBefore;
+    uint64_t passBytes = Host::getAllocatedBytes() - bytesBefore;
+    if (ms >= WARMUP)
+    {
+      nanos.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+      allocations += passAllocations;
+      bytes += passBytes;
+      maxAllocations = std::max<uint64_t>(maxAllocations, passAllocations);
+    }
+    Host::advance(1000);
+  }
+
+  std::sort(nanos.begin(), nanos.end());
+  printf("%-10s %8zu %9.2f %9.2f %9.2f %9.2f %9.3f %7llu %9.1f  %s\n", scenario.name, nanos.size(),
+         percentile(nanos, 0.5) / 1000.0, percentile(nanos, 0.9) / 1000.0, percentile(nanos, 0.99) / 1000.0, nanos.back() / 1000.0,
+         (double)allocations / nanos.size(), (unsigned long long)maxAllocations, (double)bytes / nanos.size(), scenario.description);
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t seconds = 60;
+  std::vector<const Scenario *> selected;
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+    {
+      seconds = max(1, atoi(argv[++i]));
+      continue;
+    }
+    for (const Scenario &scenario : scenarios)
+      if (strcmp(argv[i], scenario.name) == 0)
+        selected.push_back(&scenario);
+  }
+  if (selected.empty())
+    for (const Scenario &scenario : scenarios)
+      selected.push_back(&scenario);
+
+  printf("%-10s %8s %9s %9s %9s %9s %9s %7s %9s\n", "scenario", "loops", "p50 us", "p90 us", "p99 us", "max us", "allocs", "max", "bytes");
+  fflush(stdout);
+  for (const Scenario *scenario : selected)
+  {
+    // the sketch lives in globals: a fresh process per scenario boots it anew
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+      run(*scenario, seconds);
+      fflush(stdout);
+      _exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+      return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,121 @@
+// Replays a trace of Thermostat.ino's loop inputs on the virtual clock and
+// reports how much faster than real time it ran, with what the relays, the
+// panel and the cloud saw. A trace is what a TRACE build (DEBUG off) wrote
+// on Serial from boot on an erased device; without one, a day of a room
+// drifting through its setpoint under hourly commands is recorded first, in
+// a child process, and played back.
+//
+//   bench_replay [trace] [-d days] [-v]
+#include <Arduino.h>
+#include <Host.h>
+#include "Replay.h"
+#include <chrono>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define DAY 86400000UL
+
+void setup();
+void loop();
+
+static std::string record(unsigned long length)
+{
+  int fds[2];
+  if (pipe(fds) != 0)
+    return "";
+  pid_t pid = fork();
+  if (pid == 0)
+  {
+    close(fds[0]);
+    Host::setSerialOutput([&](const uint8_t *data, size_t length) { write(fds[1], data, length); });
+    Replay::attachHardware();
+    Host::setDHT(21, 45);
+    setup();
+    for (unsigned long ms = 0; ms < length; ms++)
+    {
+      if (ms == 1000)
+        Host::submitPortal("home", {{"sinric_apiKey", "key"}, {"sinric_devId", "dev1"}});
+      if (ms % 3600000 == 5000)
+      {
+        char frame[160];
+        snprintf(frame, sizeof(frame),
+                 "{\"deviceId\":\"dev1\",\"action\":\"action.devices.commands.ThermostatSetMode\",\"value\":{\"thermostatMode\":\"%s\"}}",
+                 ms / 3600000 % 2 ? "cool" : "heat");
+        Host::cloudSend(frame);
+      }
+      if (ms % 10000 == 0)
+      {
+        uint32_t phase = ms % 600000;
+        Host::setDHT(phase < 300000 ? 16 + phase / 25000.0f : 28 - (phase - 300000) / 25000.0f, 45);
+      }
+      loop();
+      Host::advance(1000);
+    }
+    _exit(0);
+  }
+  close(fds[1]);
+  std::string trace;
+  char buffer[4096];
+  ssize_t n;
+  while ((n = read(fds[0], buffer, sizeof(buffer))) > 0)
+    trace.append(buffer, n);
+  close(fds[0]);
+  waitpid(pid, NULL, 0);
+  return trace;
+}
+
+static size_t lines(const std::string &text) { return std::count(text.begin(), text.end(), '\n'); }
+
+int main(int argc, char **argv)
+{
+  const char *path = NULL;
+  unsigned long days = 1;
+  bool verbose = false;
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-d") == 0 && i + 1 < argc)
+      days = max(1, atoi(argv[++i]));
+    else if (strcmp(argv[i], "-v") == 0)
+      verbose = true;
+    else
+      path = argv[i];
+  }
+
+  std::string trace;
+  if (path != NULL)
+  {
+    FILE *in = fopen(path, "rb");
+    if (in == NULL)
+    {
+      perror(path);
+      return 1;
+    }
+    char buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), in)) > 0)
+      trace.append(buffer, n);
+    fclose(in);
+  }
+  else
+    trace = record(days * DAY);
+
+  Replay::attachHardware();
+  Replay::Log log;
+  auto start = std::chrono::steady_clock::now();
+  if (!Replay::run((const uint8_t *)trace.data(), trace.size(), 0, &log))
+  {
+    fprintf(stderr, "not a trace\n");
+    return 1;
+  }
+  double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  double played = millis() / 1000.0;
+
+  if (verbose)
+    printf("%s%s%s", log.relays.c_str(), log.panel.c_str(), log.cloud.c_str());
+  printf("trace      %zu bytes, %.1f h\n", trace.size(), played / 3600);
+  printf("replay     %.3f s wall, %.0fx real time\n", wall, played / wall);
+  printf("lines      %zu changes of the relays and the LED\n", lines(log.relays));
+  printf("panel      %zu frames\n", lines(log.panel));
+  printf("cloud      %zu frames\n", lines(log.cloud));
+  return 0;
+}
@@ -0,0 +1,77 @@
+// Cost of one Thermostat::runner() pass per hook flavor: std::function
+// hooks (the old sketch), compile-time hooks doing the same work (the
+// sketch now) and no hooks at all. Every flavor sees the same noisy
+// readings, with the sketch's deadband and cycle settings: runner() every
+// 100 ms, a new DHT sample every 2 s.
+//
+//   bench_runner [calls]
+#include <Arduino.h>
+#include "Thermostat.h"
+#include <chrono>
+
+#define READINGS 4096
+#define ROUNDS 5
+
+static float readings[READINGS];
+static volatile uint32_t notified; // what the hooks did, kept observable
+
+struct CountingHooks : ThermostatNoHooks
+{
+  ThermostatState onStateChange(ThermostatState oldState, ThermostatState state) { notified++; return state; }
+  float onPointChange(float oldPoint, float point) { notified++; return point; }
+  float onTemperatureChange(float oldTemperature, float temperature) { notified++; return temperature; }
+};
+
+template <class T>
+static void configure(T &thermostat)
+{
+  thermostat.begin();
+  thermostat.setHysteresis(1.0);
+  thermostat.setMinOnTime(180000);
+  thermostat.setMinOffTime(180000);
+  thermostat.setFanOverrun(30000);
+  thermostat.setTemperatureDeadband(0.2);
+}
+
+// best of ROUNDS, each on a fresh clock so every round replays the stream
+template <class T>
+static void measure(const char *name, T &thermostat, uint32_t calls)
+{
+  double best = 0;
+  uint32_t before = notified;
+  unsigned long now = 0;
+  for (int round = 0; round < ROUNDS; round++)
+  {
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < calls; i++, now += 100)
+      thermostat.runner(ThermostatState::HEAT, (i >> 16) & 1 ? 21 : 20, readings[(i / 20) % READINGS], now);
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / calls;
+    if (round == 0 || ns < best)
+      best = ns;
+  }
+  printf("%-10s %10u %9.2f %10u %10u\n", name, calls, best, (notified - before) / ROUNDS, thermostat.getCycles() / ROUNDS);
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t calls = argc > 1 ? strtoul(argv[1], NULL, 10) : 5000000;
+  // a room swinging around the point with sensor noise, in DHT11 steps
+  for (int i = 0; i < READINGS; i++)
+    readings[i] = roundf((20 + 2 * sinf(i * 6.2832f / READINGS) + random(-3, 4) * 0.1f) * 10) / 10;
+
+  BasicThermostat<ThermostatFunctionHooks> functions;
+  configure(functions);
+  functions.setOnStateChange([](ThermostatState oldState, ThermostatState state) { notified++; return state; });
+  functions.setOnPointChange([](float oldPoint, float point) { notified++; return point; });
+  functions.setOnTemperatureChange([](float oldTemperature, float temperature) { notified++; return temperature; });
+  BasicThermostat<CountingHooks> hooks;
+  configure(hooks);
+  BasicThermostat<ThermostatNoHooks> none;
+  configure(none);
+
+  printf("%-10s %10s %9s %10s %10s\n", "hooks", "calls", "ns/call", "notified", "cycles");
+  measure("function", functions, calls);
+  measure("static", hooks, calls);
+  measure("none", none, calls);
+  return 0;
+}
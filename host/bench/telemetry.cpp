@@ -0,0 +1,142 @@
+// Cost of encoding the outbound Sinric messages: ThermostatTelemetry's
+// templates against the ArduinoJson document the sketch used before,
+// when CMake found ArduinoJson at configure time. The same stream of
+// messages goes through each encoder; the figures are time per message
+// (best of ROUNDS), heap allocations and bytes per message, and the size
+// of the encoded frame.
+//
+//   bench_telemetry [messages]
+#include <Arduino.h>
+#include <Host.h>
+#include "ThermostatTelemetry.h"
+#include <chrono>
+#include <string>
+
+#if HAVE_ARDUINOJSON
+#define ARDUINOJSON_ENABLE_ARDUINO_STRING 0
+#define ARDUINOJSON_ENABLE_ARDUINO_STREAM 0
+#define ARDUINOJSON_ENABLE_ARDUINO_PRINT 0
+#define ARDUINOJSON_ENABLE_PROGMEM 0
+#include <ArduinoJson.h>
+#endif
+
+#define ROUNDS 5
+#define DEVICE "5f1d8e2a9c3b4e0012ab34cd"
+
+static const char *modes[] = {"heat", "cool", "fan", "off"};
+static volatile size_t sink; // keeps the encoded frames observable
+
+// one message of the stream: mostly settings, with mode and power changes
+struct Message
+{
+  uint8_t kind;
+  const char *text;
+  float point, temperature, humidity;
+};
+
+static Message message(uint32_t i)
+{
+  Message m = {(uint8_t)(i % 8 == 0 ? 0 : i % 8 == 1 ? 1 : 2), modes[i % 4], 16.0f + i % 15, 18 + (i % 120) / 10.0f, 30.0f + i % 40};
+  if (m.kind == 0)
+    m.text = i % 16 ? "ON" : "OFF";
+  if (i % 97 == 0)
+    m.temperature = NAN;
+  return m;
+}
+
+static size_t templates(const Message &m)
+{
+  switch (m.kind)
+  {
+  case 0:
+    ThermostatTelemetry::powerState(DEVICE, m.text);
+    break;
+  case 1:
+    ThermostatTelemetry::thermostatMode(DEVICE, m.text);
+    break;
+  default:
+    ThermostatTelemetry::temperatureSetting(DEVICE, m.point, "CELSIUS", m.temperature, m.humidity);
+    break;
+  }
+  return ThermostatTelemetry::length();
+}
+
+#if HAVE_ARDUINOJSON
+// through operator new, so the fake core counts the document's heap
+struct CountedAllocator
+{
+  void *allocate(size_t size) { return ::operator new(size); }
+  void deallocate(void *p) { ::operator delete(p); }
+  void *reallocate(void *p, size_t size) { return NULL; } // only shrinkToFit() calls it
+};
+
+// the old senders: a 1024 byte document per message, serialized into a
+// growing string
+static size_t document(const Message &m)
+{
+  BasicJsonDocument<CountedAllocator> root(1024);
+  switch (m.kind)
+  {
+  case 0:
+    root["deviceId"] = DEVICE;
+    root["action"] = "setPowerState";
+    root["value"] = m.text;
+    break;
+  case 1:
+    root["deviceId"] = DEVICE;
+    root["action"] = "SetThermostatMode";
+    root["value"] = m.text;
+    break;
+  default:
+  {
+    root["action"] = "SetTemperatureSetting";
+    root["deviceId"] = DEVICE;
+    JsonObject setting = root.createNestedObject("value").createNestedObject("temperatureSetting");
+    setting["setPoint"] = m.point;
+    setting["scale"] = "CELSIUS";
+    setting["ambientTemperature"] = m.temperature;
+    setting["ambientHumidity"] = m.humidity;
+    break;
+  }
+  }
+  std::string frame;
+  serializeJson(root, frame);
+  return frame.size();
+}
+#endif
+
+static void measure(const char *name, size_t (*encode)(const Message &), uint32_t messages)
+{
+  double best = 0;
+  uint64_t frameBytes = 0;
+  for (int round = 0; round < ROUNDS; round++)
+  {
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < messages; i++)
+      sink += encode(message(i));
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / messages;
+    if (round == 0 || ns < best)
+      best = ns;
+  }
+
+  // heap traffic on one more pass, apart from the timed ones
+  uint32_t allocationsBefore = Host::getAllocations();
+  uint64_t bytesBefore = Host::getAllocatedBytes();
+  for (uint32_t i = 0; i < messages; i++)
+    frameBytes += encode(message(i));
+  printf("%-12s %10u %9.1f %9.3f %10.1f %9.1f\n", name, messages, best, (double)(Host::getAllocations() - allocationsBefore) / messages,
+         (double)(Host::getAllocatedBytes() - bytesBefore) / messages, (double)frameBytes / messages);
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t messages = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+  printf("%-12s %10s %9s %9s %10s %9s\n", "encoder", "messages", "ns/msg", "allocs", "heap B", "frame B");
+  measure("templates", templates, messages);
+#if HAVE_ARDUINOJSON
+  measure("arduinojson", document, messages);
+#else
+  printf("%-12s ArduinoJson.h not found at configure time, not compared\n", "arduinojson");
+#endif
+  return 0;
+}
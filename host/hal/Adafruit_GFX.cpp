@@ -0,0 +1,77 @@
+#include "Adafruit_GFX.h"
+
+Adafruit_GFX::Adafruit_GFX(int16_t w, int16_t h) : WIDTH(w), HEIGHT(h), _width(w), _height(h) {}
+
+void Adafruit_GFX::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+  for (int16_t i = x; i < x + w; i++)
+    for (int16_t j = y; j < y + h; j++)
+      drawPixel(i, j, color);
+}
+
+void Adafruit_GFX::fillScreen(uint16_t color) { fillRect(0, 0, _width, _height, color); }
+
+void Adafruit_GFX::drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, uint8_t size)
+{
+  if (x >= _width || y >= _height || x + 6 * size - 1 < 0 || y + 8 * size - 1 < 0)
+    return;
+  for (int8_t i = 0; i < 5; i++)
+  {
+    uint8_t line = c == ' ' ? 0 : (uint8_t)(c * 0x9D + i * 0x3B) & 0x7F;
+    for (int8_t j = 0; j < 8; j++, line >>= 1)
+    {
+      if (line & 1)
+        size == 1 ? drawPixel(x + i, y + j, color) : fillRect(x + i * size, y + j * size, size, size, color);
+      else if (bg != color)
+        size == 1 ? drawPixel(x + i, y + j, bg) : fillRect(x + i * size, y + j * size, size, size, bg);
+    }
+  }
+  if (bg != color)
+    size == 1 ? fillRect(x + 5, y, 1, 8, bg) : fillRect(x + 5 * size, y, size, 8 * size, bg);
+}
+
+void Adafruit_GFX::drawBitmap(int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h, uint16_t color)
+{
+  int16_t byteWidth = (w + 7) / 8;
+  for (int16_t j = 0; j < h; j++)
+    for (int16_t i = 0; i < w; i++)
+      if (pgm_read_byte(&bitmap[j * byteWidth + i / 8]) & (0x80 >> (i & 7)))
+        drawPixel(x + i, y + j, color);
+}
+
+void Adafruit_GFX::setCursor(int16_t x, int16_t y)
+{
+  cursor_x = x;
+  cursor_y = y;
+}
+
+void Adafruit_GFX::setTextColor(uint16_t c) { textcolor = textbgcolor = c; }
+
+void Adafruit_GFX::setTextColor(uint16_t c, uint16_t bg)
+{
+  textcolor = c;
+  textbgcolor = bg;
+}
+
+void Adafruit_GFX::setTextSize(uint8_t size) { textsize_x = textsize_y = size > 0 ? size : 1; }
+void Adafruit_GFX::setTextWrap(bool w) { wrap = w; }
+
+size_t Adafruit_GFX::write(uint8_t c)
+{
+  if (c == '\n')
+  {
+    cursor_x = 0;
+    cursor_y += textsize_y * 8;
+  }
+  else if (c != '\r')
+  {
+    if (wrap && cursor_x + textsize_x * 6 > _width)
+    {
+      cursor_x = 0;
+      cursor_y += textsize_y * 8;
+    }
+    drawChar(cursor_x, cursor_y, c, textcolor, textbgcolor, textsize_x);
+    cursor_x += textsize_x * 6;
+  }
+  return 1;
+}
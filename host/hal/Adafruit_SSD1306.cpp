@@ -0,0 +1,124 @@
+#include "Adafruit_SSD1306.h"
+
+Adafruit_SSD1306::Adafruit_SSD1306(uint8_t w, uint8_t h, TwoWire *twi, int8_t rst_pin) : Adafruit_GFX(w, h), wire(twi) {}
+
+Adafruit_SSD1306::~Adafruit_SSD1306() { free(buffer); }
+
+uint8_t *Adafruit_SSD1306::getBuffer() { return buffer; }
+
+bool Adafruit_SSD1306::begin(uint8_t vcs, uint8_t addr, bool reset, bool periphBegin)
+{
+  if (buffer == NULL && (buffer = (uint8_t *)malloc(WIDTH * ((HEIGHT + 7) / 8))) == NULL)
+    return false;
+  clearDisplay();
+  i2caddr = addr;
+  if (periphBegin)
+    wire->begin();
+
+  static const uint8_t init[] = {SSD1306_DISPLAYOFF, SSD1306_SETDISPLAYCLOCKDIV, 0x80, SSD1306_SETMULTIPLEX};
+  ssd1306_commandList(init, sizeof(init));
+  ssd1306_command(HEIGHT - 1);
+  static const uint8_t init2[] = {SSD1306_SETDISPLAYOFFSET, 0x0, SSD1306_SETSTARTLINE | 0x0, SSD1306_CHARGEPUMP};
+  ssd1306_commandList(init2, sizeof(init2));
+  ssd1306_command(vcs == SSD1306_EXTERNALVCC ? 0x10 : 0x14);
+  static const uint8_t init3[] = {SSD1306_MEMORYMODE, 0x00, SSD1306_SEGREMAP | 0x1, SSD1306_COMSCANDEC};
+  ssd1306_commandList(init3, sizeof(init3));
+  static const uint8_t init4[] = {SSD1306_SETCOMPINS, 0x02, SSD1306_SETCONTRAST, 0x8F, SSD1306_SETPRECHARGE, 0xF1,
+                                  SSD1306_SETVCOMDETECT, 0x40, SSD1306_DISPLAYALLON_RESUME, SSD1306_NORMALDISPLAY, SSD1306_DISPLAYON};
+  ssd1306_commandList(init4, sizeof(init4));
+  return true;
+}
+
+void Adafruit_SSD1306::ssd1306_command(uint8_t c)
+{
+  wire->beginTransmission(i2caddr);
+  wire->write((uint8_t)0x00);
+  wire->write(c);
+  wire->endTransmission();
+}
+
+void Adafruit_SSD1306::ssd1306_commandList(const uint8_t *c, uint8_t n)
+{
+  wire->beginTransmission(i2caddr);
+  wire->write((uint8_t)0x00);
+  uint8_t bytesOut = 1;
+  while (n--)
+  {
+    if (bytesOut >= BUFFER_LENGTH)
+    {
+      wire->endTransmission();
+      wire->beginTransmission(i2caddr);
+      wire->write((uint8_t)0x00);
+      bytesOut = 1;
+    }
+    wire->write(*c++);
+    bytesOut++;
+  }
+  wire->endTransmission();
+}
+
+void Adafruit_SSD1306::display()
+{
+  static const uint8_t window[] = {SSD1306_PAGEADDR, 0, 0xFF, SSD1306_COLUMNADDR, 0};
+  ssd1306_commandList(window, sizeof(window));
+  ssd1306_command(WIDTH - 1);
+
+  uint16_t count = WIDTH * ((HEIGHT + 7) / 8);
+  uint8_t *ptr = buffer;
+  wire->beginTransmission(i2caddr);
+  wire->write((uint8_t)0x40);
+  uint8_t bytesOut = 1;
+  while (count--)
+  {
+    if (bytesOut >= BUFFER_LENGTH)
+    {
+      wire->endTransmission();
+      wire->beginTransmission(i2caddr);
+      wire->write((uint8_t)0x40);
+      bytesOut = 1;
+    }
+    wire->write(*ptr++);
+    bytesOut++;
+  }
+  wire->endTransmission();
+}
+
+void Adafruit_SSD1306::clearDisplay()
+{
+  if (buffer != NULL)
+    memset(buffer, 0, WIDTH * ((HEIGHT + 7) / 8));
+}
+
+void Adafruit_SSD1306::invertDisplay(bool i) { ssd1306_command(i ? SSD1306_INVERTDISPLAY : SSD1306_NORMALDISPLAY); }
+
+void Adafruit_SSD1306::dim(bool dim)
+{
+  ssd1306_command(SSD1306_SETCONTRAST);
+  ssd1306_command(dim ? 0 : 0x8F);
+}
+
+void Adafruit_SSD1306::drawPixel(int16_t x, int16_t y, uint16_t color)
+{
+  if (buffer == NULL || x < 0 || x >= _width || y < 0 || y >= _height)
+    return;
+  uint8_t *byte = &buffer[x + (y / 8) * WIDTH];
+  switch (color)
+  {
+  case SSD1306_WHITE:
+    *byte |= 1 << (y & 7);
+    break;
+  case SSD1306_BLACK:
+    *byte &= ~(1 << (y & 7));
+    break;
+  case SSD1306_INVERSE:
+    *byte ^= 1 << (y & 7);
+    break;
+  }
+}
+
+bool Adafruit_SSD1306::getPixel(int16_t x, int16_t y)
+{
+  if (buffer == NULL || x < 0 || x >= _width || y < 0 || y >= _height)
+    return false;
+  return buffer[x + (y / 8) * WIDTH] & (1 << (y & 7));
+}
@@ -0,0 +1,368 @@
+#include "Arduino.h"
+#include "Host.h"
+#include <atomic>
+#include <chrono>
+#include <malloc.h>
+#include <new>
+#include <queue>
+#include <vector>
+
+#define HOST_PINS 256
+#define HOST_HEAP (64u << 20) // getFreeHeap() counts down from here
+
+namespace
+{
+  struct Line
+  {
+    std::atomic<uint8_t> mode{INPUT}, output{LOW}, input{LOW};
+    bool driven = false; // the host set the input level
+    void (*handler)(void *) = NULL;
+    void (*plain)() = NULL;
+    void *arg = NULL;
+    int edge = 0;
+  };
+
+  struct Event
+  {
+    uint64_t at, order;
+    uint8_t pin, level;
+    bool operator>(const Event &other) const { return at != other.at ? at > other.at : order > other.order; }
+  };
+
+  Line lines[HOST_PINS];
+  // NodeMCU board: external pull-ups on the GPIO0 (flash button) and GPIO2
+  // strapping pins, so both idle high
+  struct BoardPullUps
+  {
+    BoardPullUps() { lines[D3].input = lines[D4].input = HIGH; }
+  } boardPullUps;
+  int analogs[HOST_PINS];
+  std::function<void(uint8_t, uint8_t)> onWrite;
+  std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+  uint64_t eventOrder = 0;
+
+  bool realTime = false;
+  std::atomic<uint64_t> virtualMicros{0};
+  std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+  int64_t dispatchMicros = -1; // micros() inside a dispatched event
+
+  uint32_t seed = 1;
+
+  std::atomic<uint32_t> allocations{0};
+  std::atomic<uint64_t> allocatedBytes{0}, liveBytes{0};
+
+  // DHT on a line: idle high, answers a long enough start pulse
+  uint8_t dhtPin = 0xFF, dhtType = 11;
+  float dhtTemperature = NAN, dhtHumidity = NAN;
+  uint64_t dhtLowSince = 0;
+  uint32_t dhtFrames = 0;
+
+  uint8_t level(uint8_t pin)
+  {
+    Line &line = lines[pin];
+    return line.mode == OUTPUT ? line.output.load() : line.input.load();
+  }
+
+  // an interrupt fires on any level change of its line, as on the chip,
+  // whether an input moved or the sketch drove an output
+  void settle(uint8_t pin, uint8_t before)
+  {
+    Line &line = lines[pin];
+    uint8_t after = level(pin);
+    if (after == before || (line.handler == NULL && line.plain == NULL))
+      return;
+    if (line.edge == CHANGE || (line.edge == RISING && after == HIGH) || (line.edge == FALLING && after == LOW))
+    {
+      if (line.handler != NULL)
+        line.handler(line.arg);
+      else
+        line.plain();
+    }
+  }
+
+  void dispatch(uint64_t until)
+  {
+    while (!events.empty() && events.top().at <= until)
+    {
+      Event event = events.top();
+      events.pop();
+      if (!realTime && event.at > virtualMicros)
+        virtualMicros = event.at;
+      dispatchMicros = event.at;
+      Host::setInput(event.pin, event.level);
+      dispatchMicros = -1;
+    }
+  }
+
+  uint64_t now()
+  {
+    if (dispatchMicros >= 0)
+      return dispatchMicros;
+    if (!realTime)
+      return virtualMicros;
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - epoch).count();
+  }
+
+  // DHT frame: 80 us low and 80 us high, then 40 bits of a 50 us low and a
+  // 27 us (0) or 70 us (1) high, then 50 us low and the line is released
+  void dhtAnswer(uint64_t pulse)
+  {
+    if (pulse < (dhtType == 11 ? 18000u : 1000u) || isnan(dhtTemperature) || isnan(dhtHumidity))
+      return;
+    uint8_t data[5];
+    if (dhtType == 11)
+    {
+      float temperature = fabsf(dhtTemperature), humidity = dhtHumidity;
+      int t = lroundf(temperature * 10), h = lroundf(humidity * 10);
+      data[0] = h / 10;
+      data[1] = h % 10;
+      data[2] = t / 10;
+      data[3] = (t % 10) | (dhtTemperature < 0 ? 0x80 : 0);
+    }
+    else
+    {
+      int t = lroundf(fabsf(dhtTemperature) * 10), h = lroundf(dhtHumidity * 10);
+      data[0] = h >> 8;
+      data[1] = h & 0xFF;
+      data[2] = ((t >> 8) & 0x7F) | (dhtTemperature < 0 ? 0x80 : 0);
+      data[3] = t & 0xFF;
+    }
+    data[4] = data[0] + data[1] + data[2] + data[3];
+
+    uint64_t t = now() + 30;
+    Host::schedule(t, dhtPin, LOW);
+    Host::schedule(t += 80, dhtPin, HIGH);
+    Host::schedule(t += 80, dhtPin, LOW);
+    for (uint8_t bit = 0; bit < 40; bit++)
+    {
+      Host::schedule(t += 50, dhtPin, HIGH);
+      Host::schedule(t += (data[bit / 8] & (0x80 >> (bit % 8))) ? 70 : 27, dhtPin, LOW);
+    }
+    Host::schedule(t += 50, dhtPin, HIGH);
+    dhtFrames++;
+  }
+}
+
+unsigned long millis() { return now() / 1000; }
+unsigned long micros() { return now(); }
+
+void delay(unsigned long ms)
+{
+  if (!realTime)
+    Host::advance((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+  if (!realTime)
+    Host::advance(us);
+}
+
+void yield() {}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+  Line &line = lines[pin];
+  uint8_t before = level(pin);
+  bool release = pin == dhtPin && line.mode == OUTPUT && line.output == LOW && mode != OUTPUT;
+  line.mode = mode;
+  if (mode == INPUT_PULLUP && !line.driven)
+    line.input = HIGH;
+  if (pin == dhtPin && before == HIGH && level(pin) == LOW)
+    dhtLowSince = now();
+  settle(pin, before);
+  if (release)
+    dhtAnswer(now() - dhtLowSince);
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+  Line &line = lines[pin];
+  uint8_t before = level(pin);
+  value = value ? HIGH : LOW;
+  line.output = value;
+  if (pin == dhtPin && before == HIGH && level(pin) == LOW)
+    dhtLowSince = now();
+  if (onWrite != NULL)
+    onWrite(pin, value);
+  if (line.mode == OUTPUT)
+    settle(pin, before);
+}
+
+int digitalRead(uint8_t pin) { return level(pin); }
+int analogRead(uint8_t pin) { return analogs[pin]; }
+
+void attachInterrupt(uint8_t pin, void (*handler)(), int mode)
+{
+  Line &line = lines[pin];
+  line.plain = handler;
+  line.handler = NULL;
+  line.edge = mode;
+}
+
+void attachInterruptArg(uint8_t pin, void (*handler)(void *), void *arg, int mode)
+{
+  Line &line = lines[pin];
+  line.handler = handler;
+  line.plain = NULL;
+  line.arg = arg;
+  line.edge = mode;
+}
+
+void detachInterrupt(uint8_t pin)
+{
+  lines[pin].handler = NULL;
+  lines[pin].plain = NULL;
+}
+
+void noInterrupts() {}
+void interrupts() {}
+
+// xorshift32, so runs repeat for a given seed
+long random(long howbig)
+{
+  if (howbig <= 0)
+    return 0;
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  return seed % howbig;
+}
+
+long random(long howsmall, long howbig)
+{
+  return howsmall >= howbig ? howsmall : howsmall + random(howbig - howsmall);
+}
+
+void randomSeed(unsigned long value) { seed = value != 0 ? value : 1; }
+
+size_t strlcpy(char *dst, const char *src, size_t size)
+{
+  size_t length = strlen(src);
+  if (size > 0)
+  {
+    size_t n = min(length, size - 1);
+    memcpy(dst, src, n);
+    dst[n] = '\0';
+  }
+  return length;
+}
+
+uint32_t EspClass::getFreeHeap()
+{
+  uint64_t live = liveBytes;
+  return live < HOST_HEAP ? HOST_HEAP - live : 0;
+}
+
+uint32_t EspClass::getCycleCount() { return now() * getCpuFreqMHz(); }
+
+namespace Host
+{
+  void setRealTime(bool enable)
+  {
+    if (enable && !realTime)
+      epoch = std::chrono::steady_clock::now() - std::chrono::microseconds(virtualMicros.load());
+    else if (!enable && realTime)
+      virtualMicros = now();
+    realTime = enable;
+  }
+
+  bool isRealTime() { return realTime; }
+  uint64_t getMicros() { return now(); }
+
+  void advance(uint64_t us)
+  {
+    if (realTime)
+      return;
+    uint64_t target = virtualMicros + us;
+    dispatch(target);
+    virtualMicros = target;
+  }
+
+  void poll()
+  {
+    if (realTime)
+      dispatch(now());
+  }
+
+  void setInput(uint8_t pin, uint8_t value)
+  {
+    uint8_t before = level(pin);
+    lines[pin].input = value ? HIGH : LOW;
+    lines[pin].driven = true;
+    settle(pin, before);
+  }
+
+  uint8_t getOutput(uint8_t pin) { return lines[pin].output; }
+  uint8_t getMode(uint8_t pin) { return lines[pin].mode; }
+  void setOnWrite(std::function<void(uint8_t, uint8_t)> func) { onWrite = func; }
+  void setAnalog(uint8_t pin, int value) { analogs[pin] = value; }
+
+  void schedule(uint64_t at, uint8_t pin, uint8_t value)
+  {
+    events.push({at, eventOrder++, pin, value});
+  }
+
+  void attachDHT(uint8_t pin, uint8_t type)
+  {
+    dhtPin = pin;
+    dhtType = type;
+    lines[pin].input = HIGH;
+    lines[pin].driven = true;
+  }
+
+  void setDHT(float temperature, float humidity)
+  {
+    dhtTemperature = temperature;
+    dhtHumidity = humidity;
+  }
+
+  uint32_t getDHTFrames() { return dhtFrames; }
+
+  uint32_t getAllocations() { return allocations; }
+  uint64_t getAllocatedBytes() { return allocatedBytes; }
+  uint64_t getLiveBytes() { return liveBytes; }
+}
+
+// Every allocation of the program goes through here, so a host run can
+// tell how many allocations and bytes a loop() pass costs.
+static void *allocate(size_t size)
+{
+  void *p = malloc(size > 0 ? size : 1);
+  if (p == NULL)
+    throw std::bad_alloc();
+  size_t usable = malloc_usable_size(p);
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  allocatedBytes.fetch_add(usable, std::memory_order_relaxed);
+  liveBytes.fetch_add(usable, std::memory_order_relaxed);
+  return p;
+}
+
+static void release(void *p)
+{
+  if (p == NULL)
+    return;
+  liveBytes.fetch_sub(malloc_usable_size(p), std::memory_order_relaxed);
+  free(p);
+}
+
+void *operator new(size_t size) { return allocate(size); }
+void *operator new[](size_t size) { return allocate(size); }
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+  try
+  {
+    return allocate(size);
+  }
+  catch (...)
+  {
+    return NULL;
+  }
+}
+
+void *operator new[](size_t size, const std::nothrow_t &tag) noexcept { return operator new(size, tag); }
+void operator delete(void *p) noexcept { release(p); }
+void operator delete[](void *p) noexcept { release(p); }
+void operator delete(void *p, size_t) noexcept { release(p); }
+void operator delete[](void *p, size_t) noexcept { release(p); }
@@ -0,0 +1,223 @@
+#ifndef Arduino_h
+#define Arduino_h
+
+// Host stand-in for the ESP8266 Arduino core, enough of it for the sketch
+// and its modules to build and run unmodified on Linux. The clock, the
+// pins and their interrupts, the serial port and the flash are simulated;
+// host programs drive them through Host.h.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <functional>
+#include <string>
+
+using std::max;
+using std::min;
+
+typedef uint8_t byte;
+typedef bool boolean;
+typedef unsigned int uint;
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x00
+#define INPUT_PULLUP 0x02
+#define OUTPUT 0x01
+
+#define CHANGE 0x03
+#define FALLING 0x02
+#define RISING 0x01
+
+// NodeMCU pin names
+#define D0 16
+#define D1 5
+#define D2 4
+#define D3 0
+#define D4 2
+#define D5 14
+#define D6 12
+#define D7 13
+#define D8 15
+#define D9 3
+#define D10 1
+#define A0 17
+
+#define IRAM_ATTR
+#define ICACHE_RAM_ATTR
+
+#define PROGMEM
+#define PGM_P const char *
+#define PSTR(s) (s)
+#define F(s) (s)
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+#define memcpy_P memcpy
+#define memcmp_P memcmp
+#define strlen_P strlen
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+#define snprintf_P snprintf
+#define vsnprintf_P vsnprintf
+
+#define SPI_FLASH_SEC_SIZE 4096
+
+#define digitalPinToInterrupt(pin) (pin)
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t level);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+
+// Host interrupts only fire from the host side (Host::advance(),
+// Host::setInput()), never in the middle of loop(), so masking is a no-op.
+void attachInterrupt(uint8_t pin, void (*handler)(), int mode);
+void attachInterruptArg(uint8_t pin, void (*handler)(void *), void *arg, int mode);
+void detachInterrupt(uint8_t pin);
+void noInterrupts();
+void interrupts();
+
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+extern "C" size_t strlcpy(char *dst, const char *src, size_t size);
+
+class String
+{
+public:
+  String(const char *text = "");
+  String(const std::string &text);
+  String(char c);
+  String(int value, unsigned char base = 10);
+  String(unsigned int value, unsigned char base = 10);
+  String(long value, unsigned char base = 10);
+  String(unsigned long value, unsigned char base = 10);
+  String(float value, unsigned char decimals = 2);
+  String(double value, unsigned char decimals = 2);
+
+  const char *c_str() const { return _text.c_str(); }
+  unsigned int length() const { return _text.length(); }
+  bool isEmpty() const { return _text.empty(); }
+  char operator[](unsigned int index) const { return index < _text.length() ? _text[index] : 0; }
+  char charAt(unsigned int index) const { return (*this)[index]; }
+  int indexOf(char c, unsigned int from = 0) const;
+  int indexOf(const String &text, unsigned int from = 0) const;
+  String substring(unsigned int from) const;
+  String substring(unsigned int from, unsigned int to) const;
+  long toInt() const;
+  float toFloat() const;
+  bool equals(const String &other) const { return _text == other._text; }
+
+  String &operator+=(const String &other);
+  String &operator+=(const char *text);
+  String &operator+=(char c);
+  String &operator+=(int value);
+  String &operator+=(unsigned int value);
+  String &operator+=(long value);
+  String &operator+=(unsigned long value);
+  bool operator==(const String &other) const { return _text == other._text; }
+  bool operator==(const char *text) const { return _text == text; }
+  bool operator!=(const String &other) const { return _text != other._text; }
+  bool operator!=(const char *text) const { return _text != text; }
+  friend String operator+(const String &a, const String &b);
+  friend String operator+(const String &a, const char *b);
+  friend String operator+(const char *a, const String &b);
+
+private:
+  std::string _text;
+};
+
+class Print
+{
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size);
+  size_t write(const char *text) { return text == NULL ? 0 : write((const uint8_t *)text, strlen(text)); }
+  size_t write(const char *buffer, size_t size) { return write((const uint8_t *)buffer, size); }
+  size_t print(const char *text) { return write(text); }
+  size_t print(const String &text) { return write(text.c_str()); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int value, int base = 10) { return print((long)value, base); }
+  size_t print(unsigned int value, int base = 10) { return print((unsigned long)value, base); }
+  size_t print(long value, int base = 10);
+  size_t print(unsigned long value, int base = 10);
+  size_t print(double value, int decimals = 2);
+  size_t println();
+  template <typename T>
+  size_t println(const T &value)
+  {
+    size_t n = print(value);
+    return n + println();
+  }
+  size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class Stream : public Print
+{
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+  void setTimeout(unsigned long timeout) { _timeout = timeout; }
+  long parseInt();
+  float parseFloat();
+  size_t readBytes(char *buffer, size_t length);
+  size_t readBytesUntil(char terminator, char *buffer, size_t length);
+  String readString();
+  String readStringUntil(char terminator);
+
+protected:
+  unsigned long _timeout = 1000;
+};
+
+// Serial port: input is queued by Host::serialInput(), output goes to the
+// sink set with Host::setSerialOutput() (discarded by default).
+class HardwareSerial : public Stream
+{
+public:
+  void begin(unsigned long baud) {}
+  void end() {}
+  void flush() {}
+  int available() override;
+  int read() override;
+  int peek() override;
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+  using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+// Flash is a sparse image of erased (0xFF) sectors; writes can only clear
+// bits, like NOR flash. The heap figures come from the host allocator.
+class EspClass
+{
+public:
+  uint32_t getFreeHeap();
+  uint32_t getCycleCount();
+  uint8_t getCpuFreqMHz() { return 80; }
+  uint32_t getChipId() { return 0x00C0FFEE; }
+  bool flashEraseSector(uint32_t sector);
+  bool flashWrite(uint32_t address, const uint32_t *data, size_t size);
+  bool flashRead(uint32_t address, uint32_t *data, size_t size);
+  void restart() {}
+};
+
+extern EspClass ESP;
+
+#endif
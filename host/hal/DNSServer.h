@@ -0,0 +1,6 @@
+#ifndef DNSServer_h
+#define DNSServer_h
+
+#include "Arduino.h"
+
+#endif
@@ -0,0 +1,53 @@
+#include "EEPROM.h"
+
+EEPROMClass EEPROM;
+
+// A fresh sector reads as erased flash.
+EEPROMClass::EEPROMClass() { memset(_sector, 0xFF, sizeof(_sector)); }
+
+void EEPROMClass::begin(size_t size)
+{
+  _size = min(size, sizeof(_data));
+  memcpy(_data, _sector, _size);
+  _dirty = false;
+}
+
+uint8_t EEPROMClass::read(int address)
+{
+  return address >= 0 && (size_t)address < _size ? _data[address] : 0;
+}
+
+void EEPROMClass::write(int address, uint8_t value)
+{
+  if (address < 0 || (size_t)address >= _size)
+    return;
+  _data[address] = value;
+  _dirty = true;
+}
+
+bool EEPROMClass::commit()
+{
+  if (_size == 0)
+    return false;
+  if (!_dirty)
+    return true;
+  memcpy(_sector, _data, _size);
+  _dirty = false;
+  _commits++;
+  return true;
+}
+
+void EEPROMClass::end()
+{
+  commit();
+  _size = 0;
+}
+
+uint8_t *EEPROMClass::getDataPtr()
+{
+  _dirty = true;
+  return _data;
+}
+
+size_t EEPROMClass::length() { return _size; }
+uint32_t EEPROMClass::getCommits() { return _commits; }
@@ -0,0 +1,49 @@
+#ifndef EEPROM_h
+#define EEPROM_h
+
+#include "Arduino.h"
+
+// Emulated EEPROM: a RAM copy of one flash sector, written back by commit().
+class EEPROMClass
+{
+public:
+  EEPROMClass();
+  void begin(size_t size);
+  uint8_t read(int address);
+  void write(int address, uint8_t value);
+  bool commit();
+  void end();
+  uint8_t *getDataPtr();
+  size_t length();
+  uint32_t getCommits();
+
+  template <typename T>
+  T &get(int address, T &value)
+  {
+    if (address >= 0 && address + sizeof(T) <= _size)
+      memcpy((void *)&value, _data + address, sizeof(T));
+    return value;
+  }
+
+  template <typename T>
+  const T &put(int address, const T &value)
+  {
+    if (address >= 0 && address + sizeof(T) <= _size)
+    {
+      memcpy(_data + address, (const void *)&value, sizeof(T));
+      _dirty = true;
+    }
+    return value;
+  }
+
+private:
+  uint8_t _data[SPI_FLASH_SEC_SIZE];
+  uint8_t _sector[SPI_FLASH_SEC_SIZE];
+  size_t _size = 0;
+  bool _dirty = false;
+  uint32_t _commits = 0;
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef ESP8266WEBSERVER_H
+#define ESP8266WEBSERVER_H
+
+#include "ESP8266WiFi.h"
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef WiFi_h
+#define WiFi_h
+
+#include "Arduino.h"
+#include <list>
+#include <memory>
+
+typedef enum
+{
+  WL_NO_SHIELD = 255,
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_SCAN_COMPLETED = 2,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_WRONG_PASSWORD = 6,
+  WL_DISCONNECTED = 7
+} wl_status_t;
+
+struct WiFiEventStationModeConnected
+{
+  String ssid;
+  uint8_t bssid[6];
+  uint8_t channel;
+};
+
+struct WiFiEventStationModeDisconnected
+{
+  String ssid;
+  uint8_t bssid[6];
+  uint8_t reason;
+};
+
+struct WiFiEventStationModeGotIP
+{
+  uint32_t ip, mask, gw;
+};
+
+struct WiFiEventHandlerOpaque;
+typedef std::shared_ptr<WiFiEventHandlerOpaque> WiFiEventHandler;
+
+// Station driven by Host::wifiConnect()/wifiDisconnect(). As in the core, a
+// handler stays registered while the caller keeps the returned handle.
+class ESP8266WiFiClass
+{
+public:
+  wl_status_t status();
+  bool isConnected();
+  String SSID();
+  int32_t RSSI();
+  bool disconnect(bool wifioff = false);
+  void setAutoReconnect(bool autoReconnect) {}
+  WiFiEventHandler onStationModeConnected(std::function<void(const WiFiEventStationModeConnected &)> func);
+  WiFiEventHandler onStationModeDisconnected(std::function<void(const WiFiEventStationModeDisconnected &)> func);
+  WiFiEventHandler onStationModeGotIP(std::function<void(const WiFiEventStationModeGotIP &)> func);
+};
+
+extern ESP8266WiFiClass WiFi;
+
+#endif
@@ -0,0 +1,52 @@
+#include "Arduino.h"
+#include <map>
+#include <vector>
+
+#define HOST_FS_SECTORS 16
+
+EspClass ESP;
+
+// _FS_start/_FS_end bound the filesystem area as on the chip; only their
+// distance and sector alignment matter, the flash behind them is sparse.
+extern "C"
+{
+  alignas(HOST_FS_SECTORS * SPI_FLASH_SEC_SIZE) uint8_t hostFsWindow[HOST_FS_SECTORS * SPI_FLASH_SEC_SIZE];
+}
+#define HOST_STR(x) #x
+#define HOST_XSTR(x) HOST_STR(x)
+__asm__(".globl _FS_start\n.set _FS_start, hostFsWindow\n"
+        ".globl _FS_end\n.set _FS_end, hostFsWindow + " HOST_XSTR(HOST_FS_SECTORS) " * " HOST_XSTR(SPI_FLASH_SEC_SIZE) "\n");
+
+static std::map<uint32_t, std::vector<uint8_t>> flash;
+
+static std::vector<uint8_t> &sector(uint32_t index)
+{
+  std::vector<uint8_t> &bytes = flash[index];
+  if (bytes.empty())
+    bytes.assign(SPI_FLASH_SEC_SIZE, 0xFF);
+  return bytes;
+}
+
+bool EspClass::flashEraseSector(uint32_t index)
+{
+  sector(index).assign(SPI_FLASH_SEC_SIZE, 0xFF);
+  return true;
+}
+
+bool EspClass::flashWrite(uint32_t address, const uint32_t *data, size_t size)
+{
+  if ((address & 3) || (size & 3))
+    return false;
+  const uint8_t *bytes = (const uint8_t *)data;
+  for (size_t i = 0; i < size; i++, address++)
+    sector(address / SPI_FLASH_SEC_SIZE)[address % SPI_FLASH_SEC_SIZE] &= bytes[i];
+  return true;
+}
+
+bool EspClass::flashRead(uint32_t address, uint32_t *data, size_t size)
+{
+  uint8_t *bytes = (uint8_t *)data;
+  for (size_t i = 0; i < size; i++, address++)
+    bytes[i] = sector(address / SPI_FLASH_SEC_SIZE)[address % SPI_FLASH_SEC_SIZE];
+  return true;
+}
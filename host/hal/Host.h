@@ -0,0 +1,83 @@
+#ifndef Host_h
+#define Host_h
+
+#include "Arduino.h"
+#include <initializer_list>
+#include <utility>
+
+struct decode_results;
+
+// Controls for the host side of the fake core: the programs that drive
+// setup()/loop() use these to move the clock, act as the sensors and the
+// user, and watch the relays, the panel, the serial port and the cloud.
+namespace Host
+{
+  // Clock. The default is a virtual clock that only moves through
+  // advance() (and delay()), so runs are deterministic and as fast as the
+  // CPU allows; the real-time clock follows CLOCK_MONOTONIC.
+  void setRealTime(bool realTime);
+  bool isRealTime();
+  uint64_t getMicros();
+  void advance(uint64_t us);
+  void poll();
+
+  // Lines. An input level set here reads back through digitalRead() and
+  // fires the attached interrupt; outputs are what the sketch drives.
+  void setInput(uint8_t pin, uint8_t level);
+  uint8_t getOutput(uint8_t pin);
+  uint8_t getMode(uint8_t pin);
+  void schedule(uint64_t at, uint8_t pin, uint8_t level);
+  void setOnWrite(std::function<void(uint8_t pin, uint8_t level)> func);
+  void setAnalog(uint8_t pin, int value);
+
+  // DHT11/DHT22 on a pin: answers every start pulse with a frame carrying
+  // the current reading, NaN makes it stay silent.
+  void attachDHT(uint8_t pin, uint8_t type);
+  void setDHT(float temperature, float humidity);
+  uint32_t getDHTFrames();
+
+  // IR receiver: frames are handed to the next IRrecv::decode().
+  void sendIR(const decode_results &results);
+
+  // SSD1306 panel on the I2C bus; getPanel() is its RAM, 8 pages of 128
+  // columns at most, as the I2C traffic left it.
+  void attachPanel(uint8_t address);
+  const uint8_t *getPanel();
+  uint32_t getPanelBytes();
+
+  // I2C devices answer their address; a handler receives every transmission.
+  void attachI2C(uint8_t address, std::function<void(const uint8_t *data, size_t length)> func);
+  bool hasI2C(uint8_t address);
+  void transmitI2C(uint8_t address, const uint8_t *data, size_t length);
+
+  // Serial port.
+  void serialInput(const char *text);
+  void setSerialOutput(std::function<void(const uint8_t *data, size_t length)> func);
+
+  // Station: the network saved in flash, association and loss.
+  void setSavedNetwork(const char *ssid);
+  void wifiConnect(const char *ssid, int8_t rssi = -60);
+  void wifiDisconnect();
+
+  // Captive portal page saved with a network and parameter values by id;
+  // taken by the next WiFiManager::process() while the portal is open.
+  void submitPortal(const char *ssid, std::initializer_list<std::pair<const char *, const char *>> values);
+
+  // Cloud end of the WebSocketsClient: in process, the host accepts the
+  // connection, sends frames to the sketch and receives its frames.
+  void cloudAccept(bool accept);
+  void cloudSend(const char *text);
+  void cloudClose();
+  bool isCloudOpen();
+  void setOnCloudText(std::function<void(const char *text, size_t length)> func);
+  // Or a WebSocket server on TCP instead, dialed in place of the host the
+  // sketch names; the in-process end above then sees nothing.
+  void cloudServer(const char *host, uint16_t port);
+
+  // Heap as seen through operator new/delete, for allocations per loop.
+  uint32_t getAllocations();
+  uint64_t getAllocatedBytes();
+  uint64_t getLiveBytes();
+}
+
+#endif
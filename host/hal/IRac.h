@@ -0,0 +1,7 @@
+#ifndef IRAC_H_
+#define IRAC_H_
+
+#include "IRremoteESP8266.h"
+#include "IRrecv.h"
+
+#endif
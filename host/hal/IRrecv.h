@@ -0,0 +1,39 @@
+#ifndef IRRECV_H_
+#define IRRECV_H_
+
+#include "IRremoteESP8266.h"
+
+struct decode_results
+{
+  decode_type_t decode_type;
+  union
+  {
+    struct
+    {
+      uint64_t value;
+      uint32_t address;
+      uint32_t command;
+    };
+    uint8_t state[kStateSizeMax];
+  };
+  uint16_t bits;
+  volatile uint16_t *rawbuf;
+  uint16_t rawlen;
+  bool overflow;
+  bool repeat;
+};
+
+// Receiver: decode() hands out the frames queued with Host::sendIR().
+class IRrecv
+{
+public:
+  IRrecv(uint16_t recvpin, uint16_t bufsize = 1024, uint8_t timeout = 15, bool save_buffer = false);
+  void enableIRIn(bool pullup = false);
+  void disableIRIn();
+  void resume();
+  bool decode(decode_results *results);
+  void setUnknownThreshold(uint16_t length);
+  void setTolerance(uint8_t percent = kTolerance);
+};
+
+#endif
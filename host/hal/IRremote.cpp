@@ -0,0 +1,45 @@
+#include "IRrecv.h"
+#include "IRtext.h"
+#include "IRutils.h"
+#include "Host.h"
+#include <deque>
+
+const char *kCommaSpaceStr = ", ";
+
+static std::deque<decode_results> frames;
+
+IRrecv::IRrecv(uint16_t recvpin, uint16_t bufsize, uint8_t timeout, bool save_buffer) {}
+void IRrecv::enableIRIn(bool pullup) {}
+void IRrecv::disableIRIn() {}
+void IRrecv::resume() {}
+void IRrecv::setUnknownThreshold(uint16_t length) {}
+void IRrecv::setTolerance(uint8_t percent) {}
+
+bool IRrecv::decode(decode_results *results)
+{
+  if (frames.empty())
+    return false;
+  *results = frames.front();
+  frames.pop_front();
+  return true;
+}
+
+String uint64ToString(uint64_t input, uint8_t base) { return String((unsigned long)input, base); }
+
+String typeToString(const decode_type_t protocol, const bool isRepeat)
+{
+  static const char *names[] = {"UNUSED", "NEC", "SONY", "COOLIX", "DAIKIN", "MIRAGE"};
+  String name = protocol >= UNUSED && protocol <= kLastDecodeType ? names[protocol] : "UNKNOWN";
+  if (isRepeat)
+    name += " (Repeat)";
+  return name;
+}
+
+bool hasACState(const decode_type_t protocol) { return protocol == DAIKIN || protocol == MIRAGE; }
+
+int8_t irutils::lowLevelSanityCheck() { return 0; }
+
+namespace Host
+{
+  void sendIR(const decode_results &results) { frames.push_back(results); }
+}
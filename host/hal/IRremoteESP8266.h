@@ -0,0 +1,23 @@
+#ifndef IRREMOTEESP8266_H_
+#define IRREMOTEESP8266_H_
+
+#include "Arduino.h"
+
+// Protocol numbers are the host's own: traces recorded on the chip carry
+// the library's numbering.
+enum decode_type_t
+{
+  UNKNOWN = -1,
+  UNUSED = 0,
+  NEC,
+  SONY,
+  COOLIX,
+  DAIKIN,
+  MIRAGE,
+  kLastDecodeType = MIRAGE,
+};
+
+const uint8_t kTolerance = 25;
+const uint16_t kStateSizeMax = 53;
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef IRTEXT_H_
+#define IRTEXT_H_
+
+extern const char *kCommaSpaceStr;
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef IRUTILS_H_
+#define IRUTILS_H_
+
+#include "IRrecv.h"
+
+String uint64ToString(uint64_t input, uint8_t base = 10);
+String typeToString(const decode_type_t protocol, const bool isRepeat = false);
+bool hasACState(const decode_type_t protocol);
+
+namespace irutils
+{
+  int8_t lowLevelSanityCheck();
+}
+
+#endif
@@ -0,0 +1,93 @@
+#include "Arduino.h"
+#include "Host.h"
+
+#define PANEL_WIDTH 128
+#define PANEL_PAGES 8
+
+// SSD1306 controller as seen from the bus: a control byte of 0x00 starts
+// commands (arguments may follow in later transmissions), 0x40 starts data
+// written into RAM through the column/page window in horizontal mode.
+namespace
+{
+  uint8_t ram[PANEL_WIDTH * PANEL_PAGES];
+  uint8_t command = 0, arguments[6], argumentCount = 0, argumentsNeeded = 0;
+  uint8_t columnStart = 0, columnEnd = PANEL_WIDTH - 1, pageStart = 0, pageEnd = PANEL_PAGES - 1;
+  uint8_t column = 0, page = 0;
+  uint32_t bytes = 0;
+
+  uint8_t argumentsOf(uint8_t c)
+  {
+    switch (c)
+    {
+    case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3: case 0xD5: case 0xD9: case 0xDA: case 0xDB:
+      return 1;
+    case 0x21: case 0x22: case 0xA3:
+      return 2;
+    case 0x29: case 0x2A:
+      return 5;
+    case 0x26: case 0x27:
+      return 6;
+    default:
+      return 0;
+    }
+  }
+
+  void execute()
+  {
+    if (command == 0x21)
+    {
+      columnStart = column = arguments[0] & 0x7F;
+      columnEnd = arguments[1] & 0x7F;
+    }
+    else if (command == 0x22)
+    {
+      pageStart = page = arguments[0] & 0x07;
+      pageEnd = arguments[1] & 0x07;
+    }
+  }
+
+  void onCommand(uint8_t c)
+  {
+    if (argumentsNeeded > 0)
+    {
+      arguments[argumentCount++] = c;
+      if (--argumentsNeeded == 0)
+        execute();
+      return;
+    }
+    command = c;
+    argumentCount = 0;
+    argumentsNeeded = argumentsOf(c);
+    if (argumentsNeeded == 0)
+      execute();
+  }
+
+  void onData(uint8_t d)
+  {
+    ram[page * PANEL_WIDTH + column] = d;
+    if (column < columnEnd)
+      column++;
+    else
+    {
+      column = columnStart;
+      page = page < pageEnd ? page + 1 : pageStart;
+    }
+  }
+
+  void onTransmission(const uint8_t *data, size_t length)
+  {
+    bytes += length;
+    if (length == 0)
+      return;
+    bool isData = data[0] & 0x40;
+    for (size_t i = 1; i < length; i++)
+      isData ? onData(data[i]) : onCommand(data[i]);
+  }
+}
+
+namespace Host
+{
+  void attachPanel(uint8_t address) { attachI2C(address, onTransmission); }
+  const uint8_t *getPanel() { return ram; }
+  uint32_t getPanelBytes() { return bytes; }
+}
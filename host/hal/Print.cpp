@@ -0,0 +1,155 @@
+#include "Arduino.h"
+#include "Host.h"
+#include <ctype.h>
+#include <deque>
+
+HardwareSerial Serial;
+
+static std::deque<uint8_t> serialInput;
+static std::function<void(const uint8_t *, size_t)> serialOutput;
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+  size_t n = 0;
+  while (size--)
+    n += write(*buffer++);
+  return n;
+}
+
+size_t Print::print(long value, int base)
+{
+  if (base == 10)
+  {
+    char buffer[24];
+    return write(buffer, snprintf(buffer, sizeof(buffer), "%ld", value));
+  }
+  return print((unsigned long)value, base);
+}
+
+size_t Print::print(unsigned long value, int base)
+{
+  return print(String(value, (unsigned char)base));
+}
+
+size_t Print::print(double value, int decimals)
+{
+  char buffer[64];
+  return write(buffer, snprintf(buffer, sizeof(buffer), "%.*f", decimals, value));
+}
+
+size_t Print::println() { return write("\r\n"); }
+
+// As the ESP8266 core: formatted on the stack, on the heap when longer.
+size_t Print::printf(const char *format, ...)
+{
+  va_list arg;
+  va_start(arg, format);
+  char temp[64];
+  char *buffer = temp;
+  size_t len = vsnprintf(temp, sizeof(temp), format, arg);
+  va_end(arg);
+  if (len > sizeof(temp) - 1)
+  {
+    buffer = new char[len + 1];
+    va_start(arg, format);
+    vsnprintf(buffer, len + 1, format, arg);
+    va_end(arg);
+  }
+  len = write((const uint8_t *)buffer, len);
+  if (buffer != temp)
+    delete[] buffer;
+  return len;
+}
+
+// The host never waits for more input: what is queued is all there is.
+long Stream::parseInt()
+{
+  int c;
+  while ((c = peek()) >= 0 && c != '-' && !isdigit(c))
+    read();
+  bool negative = c == '-';
+  if (negative)
+    read();
+  long value = 0;
+  while ((c = peek()) >= 0 && isdigit(c))
+  {
+    value = value * 10 + c - '0';
+    read();
+  }
+  return negative ? -value : value;
+}
+
+float Stream::parseFloat()
+{
+  String text = readStringUntil('\n');
+  return text.toFloat();
+}
+
+size_t Stream::readBytes(char *buffer, size_t length)
+{
+  size_t n = 0;
+  int c;
+  while (n < length && (c = read()) >= 0)
+    buffer[n++] = c;
+  return n;
+}
+
+size_t Stream::readBytesUntil(char terminator, char *buffer, size_t length)
+{
+  size_t n = 0;
+  int c;
+  while (n < length && (c = read()) >= 0 && c != terminator)
+    buffer[n++] = c;
+  return n;
+}
+
+String Stream::readString()
+{
+  std::string text;
+  int c;
+  while ((c = read()) >= 0)
+    text += (char)c;
+  return String(text);
+}
+
+String Stream::readStringUntil(char terminator)
+{
+  std::string text;
+  int c;
+  while ((c = read()) >= 0 && c != terminator)
+    text += (char)c;
+  return String(text);
+}
+
+int HardwareSerial::available() { return serialInput.size(); }
+
+int HardwareSerial::read()
+{
+  if (serialInput.empty())
+    return -1;
+  uint8_t c = serialInput.front();
+  serialInput.pop_front();
+  return c;
+}
+
+int HardwareSerial::peek() { return serialInput.empty() ? -1 : serialInput.front(); }
+
+size_t HardwareSerial::write(uint8_t c) { return write(&c, 1); }
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+  if (serialOutput != NULL)
+    serialOutput(buffer, size);
+  return size;
+}
+
+namespace Host
+{
+  void serialInput(const char *text)
+  {
+    while (*text != '\0')
+      ::serialInput.push_back(*text++);
+  }
+
+  void setSerialOutput(std::function<void(const uint8_t *, size_t)> func) { serialOutput = func; }
+}
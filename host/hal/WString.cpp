@@ -0,0 +1,95 @@
+#include "Arduino.h"
+
+static std::string toBase(unsigned long value, unsigned char base)
+{
+  if (base < 2 || base > 36)
+    base = 10;
+  char digits[65];
+  int i = sizeof(digits) - 1;
+  digits[i] = '\0';
+  do
+  {
+    int digit = value % base;
+    digits[--i] = digit < 10 ? '0' + digit : 'a' + digit - 10;
+    value /= base;
+  } while (value > 0);
+  return digits + i;
+}
+
+String::String(const char *text) : _text(text != NULL ? text : "") {}
+String::String(const std::string &text) : _text(text) {}
+String::String(char c) : _text(1, c) {}
+String::String(unsigned int value, unsigned char base) : _text(toBase(value, base)) {}
+String::String(unsigned long value, unsigned char base) : _text(toBase(value, base)) {}
+String::String(int value, unsigned char base) : String((long)value, base) {}
+
+String::String(long value, unsigned char base)
+{
+  if (base == 10 && value < 0)
+    _text = "-" + toBase(-(unsigned long)value, base);
+  else
+    _text = toBase(value, base);
+}
+
+String::String(float value, unsigned char decimals) : String((double)value, decimals) {}
+
+String::String(double value, unsigned char decimals)
+{
+  char buffer[64];
+  snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+  _text = buffer;
+}
+
+int String::indexOf(char c, unsigned int from) const
+{
+  size_t found = _text.find(c, from);
+  return found == std::string::npos ? -1 : (int)found;
+}
+
+int String::indexOf(const String &text, unsigned int from) const
+{
+  size_t found = _text.find(text._text, from);
+  return found == std::string::npos ? -1 : (int)found;
+}
+
+String String::substring(unsigned int from) const { return substring(from, _text.length()); }
+
+String String::substring(unsigned int from, unsigned int to) const
+{
+  if (from > to)
+    std::swap(from, to);
+  if (from >= _text.length())
+    return String();
+  return String(_text.substr(from, min((size_t)to, _text.length()) - from));
+}
+
+long String::toInt() const { return atol(_text.c_str()); }
+float String::toFloat() const { return atof(_text.c_str()); }
+
+String &String::operator+=(const String &other)
+{
+  _text += other._text;
+  return *this;
+}
+
+String &String::operator+=(const char *text)
+{
+  if (text != NULL)
+    _text += text;
+  return *this;
+}
+
+String &String::operator+=(char c)
+{
+  _text += c;
+  return *this;
+}
+
+String &String::operator+=(int value) { return *this += String(value); }
+String &String::operator+=(unsigned int value) { return *this += String(value); }
+String &String::operator+=(long value) { return *this += String(value); }
+String &String::operator+=(unsigned long value) { return *this += String(value); }
+
+String operator+(const String &a, const String &b) { return String(a._text + b._text); }
+String operator+(const String &a, const char *b) { return String(a._text + b); }
+String operator+(const char *a, const String &b) { return String(a + b._text); }
@@ -0,0 +1,182 @@
+#include "WebSockets.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+static const char GUID[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+static const char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static uint32_t rotate(uint32_t value, int bits) { return value << bits | value >> (32 - bits); }
+
+// FIPS 180-1, enough for handshake keys
+static std::string sha1(const std::string &text)
+{
+  uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+  std::string message = text;
+  uint64_t bits = (uint64_t)text.size() * 8;
+  message += (char)0x80;
+  while (message.size() % 64 != 56)
+    message += (char)0;
+  for (int i = 7; i >= 0; i--)
+    message += (char)(bits >> (i * 8));
+
+  for (size_t block = 0; block < message.size(); block += 64)
+  {
+    uint32_t w[80];
+    for (int i = 0; i < 16; i++)
+      w[i] = (uint32_t)(uint8_t)message[block + 4 * i] << 24 | (uint32_t)(uint8_t)message[block + 4 * i + 1] << 16 |
+             (uint32_t)(uint8_t)message[block + 4 * i + 2] << 8 | (uint8_t)message[block + 4 * i + 3];
+    for (int i = 16; i < 80; i++)
+      w[i] = rotate(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (int i = 0; i < 80; i++)
+    {
+      uint32_t f, k;
+      if (i < 20)
+        f = (b & c) | (~b & d), k = 0x5A827999;
+      else if (i < 40)
+        f = b ^ c ^ d, k = 0x6ED9EBA1;
+      else if (i < 60)
+        f = (b & c) | (b & d) | (c & d), k = 0x8F1BBCDC;
+      else
+        f = b ^ c ^ d, k = 0xCA62C1D6;
+      uint32_t t = rotate(a, 5) + f + e + k + w[i];
+      e = d;
+      d = c;
+      c = rotate(b, 30);
+      b = a;
+      a = t;
+    }
+    h[0] += a, h[1] += b, h[2] += c, h[3] += d, h[4] += e;
+  }
+
+  std::string digest;
+  for (uint32_t word : h)
+    for (int i = 3; i >= 0; i--)
+      digest += (char)(word >> (i * 8));
+  return digest;
+}
+
+std::string WebSockets::base64(const uint8_t *data, size_t length)
+{
+  std::string out;
+  for (size_t i = 0; i < length; i += 3)
+  {
+    uint32_t chunk = data[i] << 16 | (i + 1 < length ? data[i + 1] << 8 : 0) | (i + 2 < length ? data[i + 2] : 0);
+    out += ALPHABET[chunk >> 18 & 63];
+    out += ALPHABET[chunk >> 12 & 63];
+    out += i + 1 < length ? ALPHABET[chunk >> 6 & 63] : '=';
+    out += i + 2 < length ? ALPHABET[chunk & 63] : '=';
+  }
+  return out;
+}
+
+std::string WebSockets::base64(const std::string &text) { return base64((const uint8_t *)text.data(), text.size()); }
+
+std::string WebSockets::base64Decode(const std::string &text)
+{
+  std::string out;
+  uint32_t chunk = 0;
+  int bits = 0;
+  for (char c : text)
+  {
+    const char *found = c != 0 ? strchr(ALPHABET, c) : NULL;
+    if (found == NULL)
+      break; // padding or the end of the token
+    chunk = chunk << 6 | (found - ALPHABET);
+    bits += 6;
+    if (bits >= 8)
+    {
+      bits -= 8;
+      out += (char)(chunk >> bits);
+    }
+  }
+  return out;
+}
+
+std::string WebSockets::acceptKey(const std::string &key) { return base64(sha1(key + GUID)); }
+
+std::string WebSockets::header(const std::string &head, const char *name)
+{
+  size_t length = strlen(name);
+  for (size_t line = head.find("\r\n"); line != std::string::npos; line = head.find("\r\n", line + 2))
+  {
+    size_t start = line + 2;
+    if (head.size() - start <= length || strncasecmp(head.c_str() + start, name, length) != 0 || head[start + length] != ':')
+      continue;
+    size_t value = head.find_first_not_of(' ', start + length + 1);
+    size_t end = head.find("\r\n", start);
+    return value == std::string::npos || value >= end ? "" : head.substr(value, end - value);
+  }
+  return "";
+}
+
+std::string WebSockets::frame(Opcode opcode, const char *payload, size_t length, bool mask)
+{
+  std::string out;
+  out += (char)(0x80 | opcode);
+  uint8_t maskBit = mask ? 0x80 : 0;
+  if (length < 126)
+    out += (char)(maskBit | length);
+  else if (length <= 0xFFFF)
+  {
+    out += (char)(maskBit | 126);
+    out += (char)(length >> 8);
+    out += (char)length;
+  }
+  else
+  {
+    out += (char)(maskBit | 127);
+    for (int i = 7; i >= 0; i--)
+      out += (char)((uint64_t)length >> (i * 8));
+  }
+  uint8_t key[4] = {0, 0, 0, 0};
+  if (mask)
+  {
+    uint32_t r = (uint32_t)random();
+    for (int i = 0; i < 4; i++)
+      out += (char)(key[i] = r >> (i * 8));
+  }
+  for (size_t i = 0; i < length; i++)
+    out += (char)(payload[i] ^ key[i % 4]);
+  return out;
+}
+
+bool WebSockets::parse(std::string &buffer, Opcode &opcode, std::string &payload)
+{
+  if (buffer.size() < 2)
+    return false;
+  const uint8_t *p = (const uint8_t *)buffer.data();
+  size_t at = 2;
+  uint64_t length = p[1] & 0x7F;
+  bool masked = p[1] & 0x80;
+  if (length == 126)
+  {
+    if (buffer.size() < 4)
+      return false;
+    length = p[2] << 8 | p[3];
+    at = 4;
+  }
+  else if (length == 127)
+  {
+    if (buffer.size() < 10)
+      return false;
+    length = 0;
+    for (int i = 0; i < 8; i++)
+      length = length << 8 | p[2 + i];
+    at = 10;
+  }
+  const uint8_t *key = p + at;
+  if (masked)
+    at += 4;
+  if (buffer.size() < at + length)
+    return false;
+
+  opcode = (Opcode)(p[0] & 0x0F);
+  payload.assign(buffer, at, length);
+  if (masked)
+    for (size_t i = 0; i < payload.size(); i++)
+      payload[i] ^= key[i % 4];
+  buffer.erase(0, at + length);
+  return true;
+}
@@ -0,0 +1,37 @@
+#ifndef WEBSOCKETS_H_
+#define WEBSOCKETS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+// RFC 6455 pieces shared by the TCP mode of WebSocketsClient and the host
+// tools that play the server: the handshake key and frame coding.
+namespace WebSockets
+{
+  enum Opcode : uint8_t
+  {
+    CONTINUATION = 0x0,
+    TEXT = 0x1,
+    BINARY = 0x2,
+    CLOSE = 0x8,
+    PING = 0x9,
+    PONG = 0xA,
+  };
+
+  std::string base64(const uint8_t *data, size_t length);
+  std::string base64(const std::string &text);
+  std::string base64Decode(const std::string &text);
+  // Sec-WebSocket-Accept for a Sec-WebSocket-Key
+  std::string acceptKey(const std::string &key);
+  // the value of a header in an HTTP head, empty when missing
+  std::string header(const std::string &head, const char *name);
+
+  // a whole, unfragmented frame; clients mask, servers do not
+  std::string frame(Opcode opcode, const char *payload, size_t length, bool mask);
+  // Takes the first frame off the front of buffer into opcode and payload.
+  // Returns false while the frame is incomplete.
+  bool parse(std::string &buffer, Opcode &opcode, std::string &payload);
+}
+
+#endif
@@ -0,0 +1,246 @@
+#include "WebSocketsClient.h"
+#include "ESP8266WiFi.h"
+#include "Host.h"
+#include "WebSockets.h"
+#include <arpa/inet.h>
+#include <deque>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define HANDSHAKE_TIMEOUT 2000 // ms of wall time for the server's answer
+
+static bool accepting = true, linked = false;
+static std::deque<std::string> inbound;
+static std::function<void(const char *, size_t)> onCloudText;
+static std::string serverHost;
+static uint16_t serverPort = 0;
+
+void WebSocketsClient::begin(const char *host, uint16_t port, const char *url, const char *protocol)
+{
+  _host = host;
+  _port = port;
+  _url = url;
+  _begun = true;
+  _failed = false;
+}
+
+void WebSocketsClient::setAuthorization(const char *user, const char *password)
+{
+  _authorization = String(user) + ":" + password;
+}
+
+void WebSocketsClient::fail()
+{
+  _failed = true;
+  _lastConnectionFail = millis();
+}
+
+static bool sendAll(int socket, const std::string &data)
+{
+  for (size_t sent = 0; sent < data.size();)
+  {
+    ssize_t n = send(socket, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+    if (n < 0 && errno == EAGAIN)
+    {
+      pollfd ready = {socket, POLLOUT, 0};
+      poll(&ready, 1, HANDSHAKE_TIMEOUT);
+      continue;
+    }
+    if (n <= 0)
+      return false;
+    sent += n;
+  }
+  return true;
+}
+
+// TCP mode: connect, send the upgrade request with the Basic authorization
+// the library builds from setAuthorization(), and check the server's key.
+bool WebSocketsClient::open()
+{
+  addrinfo hints = {}, *address = NULL;
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  if (getaddrinfo(serverHost.c_str(), std::to_string(serverPort).c_str(), &hints, &address) != 0)
+    return false;
+  _socket = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+  bool connected = _socket >= 0 && connect(_socket, address->ai_addr, address->ai_addrlen) == 0;
+  freeaddrinfo(address);
+  if (!connected)
+  {
+    close(false);
+    return false;
+  }
+  int one = 1;
+  setsockopt(_socket, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+  uint8_t nonce[16];
+  for (uint8_t &byte : nonce)
+    byte = random(256);
+  std::string key = WebSockets::base64(nonce, sizeof(nonce));
+  std::string request = std::string("GET ") + _url.c_str() + " HTTP/1.1\r\nHost: " + _host.c_str() + ":" + std::to_string(_port) +
+                        "\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Key: " + key +
+                        "\r\nSec-WebSocket-Version: 13\r\nSec-WebSocket-Protocol: arduino\r\n";
+  if (_authorization.length() > 0)
+    request += "Authorization: Basic " + WebSockets::base64(_authorization.c_str()) + "\r\n";
+  request += "\r\n";
+  if (!sendAll(_socket, request))
+  {
+    close(false);
+    return false;
+  }
+
+  // the answer, up to the blank line; frames may follow in the same read
+  _received.clear();
+  size_t end;
+  while ((end = _received.find("\r\n\r\n")) == std::string::npos)
+  {
+    pollfd ready = {_socket, POLLIN, 0};
+    char buffer[512];
+    ssize_t n = poll(&ready, 1, HANDSHAKE_TIMEOUT) > 0 ? recv(_socket, buffer, sizeof(buffer), 0) : -1;
+    if (n <= 0)
+    {
+      close(false);
+      return false;
+    }
+    _received.append(buffer, n);
+  }
+  std::string head = _received.substr(0, end + 2);
+  _received.erase(0, end + 4);
+  if (head.compare(0, 12, "HTTP/1.1 101") != 0 || WebSockets::header(head, "Sec-WebSocket-Accept") != WebSockets::acceptKey(key))
+  {
+    close(false);
+    return false;
+  }
+  fcntl(_socket, F_SETFL, fcntl(_socket, F_GETFL) | O_NONBLOCK);
+  return true;
+}
+
+void WebSocketsClient::close(bool notify)
+{
+  if (_socket >= 0)
+  {
+    if (notify)
+      sendAll(_socket, WebSockets::frame(WebSockets::CLOSE, NULL, 0, true));
+    ::close(_socket);
+    _socket = -1;
+  }
+  _received.clear();
+}
+
+// TCP mode: the next text frame, answering pings on the way. False when
+// none is complete; a closed or broken socket unlinks.
+bool WebSocketsClient::receive(std::string &text)
+{
+  char buffer[2048];
+  ssize_t n;
+  while ((n = recv(_socket, buffer, sizeof(buffer), 0)) > 0)
+    _received.append(buffer, n);
+  if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+    linked = false;
+
+  WebSockets::Opcode opcode;
+  while (WebSockets::parse(_received, opcode, text))
+  {
+    if (opcode == WebSockets::TEXT)
+      return true;
+    if (opcode == WebSockets::PING)
+      sendAll(_socket, WebSockets::frame(WebSockets::PONG, text.data(), text.size(), true));
+    else if (opcode == WebSockets::CLOSE)
+      linked = false;
+  }
+  return false;
+}
+
+void WebSocketsClient::loop()
+{
+  if (!_begun)
+    return;
+  if (!_connected)
+  {
+    if (_failed && millis() - _lastConnectionFail < _reconnectInterval)
+      return;
+    bool accepted = serverPort != 0 ? WiFi.isConnected() && open() : accepting && WiFi.isConnected();
+    if (!accepted)
+    {
+      fail();
+      return;
+    }
+    linked = _connected = true;
+    inbound.clear();
+    if (_cbEvent)
+      _cbEvent(WStype_CONNECTED, (uint8_t *)_url.c_str(), _url.length());
+    return;
+  }
+  std::string frame;
+  bool received = false;
+  if (serverPort != 0 && linked && WiFi.isConnected())
+    received = receive(frame);
+  if (!linked || !WiFi.isConnected())
+  {
+    close(false);
+    linked = _connected = false;
+    fail();
+    if (_cbEvent)
+      _cbEvent(WStype_DISCONNECTED, NULL, 0);
+    return;
+  }
+  if (serverPort == 0)
+  {
+    if (inbound.empty())
+      return;
+    frame = inbound.front();
+    inbound.pop_front();
+    received = true;
+  }
+  if (received && _cbEvent)
+    _cbEvent(WStype_TEXT, (uint8_t *)&frame[0], frame.length());
+}
+
+bool WebSocketsClient::sendTXT(const char *payload, size_t length, bool headerToPayload)
+{
+  if (!_connected || !linked)
+    return false;
+  if (length == 0)
+    length = strlen(payload);
+  if (_socket >= 0)
+  {
+    if (!sendAll(_socket, WebSockets::frame(WebSockets::TEXT, payload, length, true)))
+      linked = false;
+    return linked;
+  }
+  if (onCloudText)
+    onCloudText(payload, length);
+  return true;
+}
+
+void WebSocketsClient::disconnect()
+{
+  if (!_connected)
+    return;
+  close(true);
+  linked = _connected = false;
+  fail();
+  if (_cbEvent)
+    _cbEvent(WStype_DISCONNECTED, NULL, 0);
+}
+
+namespace Host
+{
+  void cloudAccept(bool accept) { accepting = accept; }
+  void cloudSend(const char *text) { inbound.push_back(text); }
+  void cloudClose() { linked = false; }
+  bool isCloudOpen() { return linked; }
+  void setOnCloudText(std::function<void(const char *text, size_t length)> func) { onCloudText = func; }
+
+  void cloudServer(const char *host, uint16_t port)
+  {
+    serverHost = host;
+    serverPort = port;
+  }
+}
@@ -0,0 +1,57 @@
+#ifndef WEBSOCKETSCLIENT_H_
+#define WEBSOCKETSCLIENT_H_
+
+#include "Arduino.h"
+#include <string>
+
+typedef enum
+{
+  WStype_ERROR,
+  WStype_DISCONNECTED,
+  WStype_CONNECTED,
+  WStype_TEXT,
+  WStype_BIN,
+  WStype_FRAGMENT_TEXT_START,
+  WStype_FRAGMENT_BIN_START,
+  WStype_FRAGMENT,
+  WStype_FRAGMENT_FIN,
+  WStype_PING,
+  WStype_PONG,
+} WStype_t;
+
+// Client side of the socket with the event flow of the library: the first
+// loop() connects, a lost connection is retried after the reconnect
+// interval, and every received frame is one WStype_TEXT event from loop().
+// The other end is the host (Host::cloudAccept() and friends), or a real
+// WebSocket server over TCP once Host::cloudServer() names one.
+class WebSocketsClient
+{
+public:
+  typedef std::function<void(WStype_t type, uint8_t *payload, size_t length)> WebSocketClientEvent;
+
+  void begin(const char *host, uint16_t port, const char *url = "/", const char *protocol = "arduino");
+  void onEvent(WebSocketClientEvent cbEvent) { _cbEvent = cbEvent; }
+  void setAuthorization(const char *user, const char *password);
+  void setReconnectInterval(unsigned long time) { _reconnectInterval = time; }
+  void loop();
+  bool sendTXT(const char *payload, size_t length = 0, bool headerToPayload = false);
+  bool sendTXT(const String &payload) { return sendTXT(payload.c_str(), payload.length()); }
+  bool isConnected() { return _connected; }
+  void disconnect();
+
+private:
+  WebSocketClientEvent _cbEvent;
+  String _host, _url, _authorization;
+  uint16_t _port = 80;
+  unsigned long _reconnectInterval = 500, _lastConnectionFail = 0;
+  bool _begun = false, _connected = false, _failed = false;
+  int _socket = -1;        // TCP mode
+  std::string _received;   // bytes not yet taken as frames
+
+  void fail();
+  bool open();
+  void close(bool notify);
+  bool receive(std::string &text);
+};
+
+#endif
@@ -0,0 +1,101 @@
+#include "ESP8266WiFi.h"
+#include "Host.h"
+
+ESP8266WiFiClass WiFi;
+
+struct WiFiEventHandlerOpaque
+{
+  int kind;
+  std::function<void(const void *)> func;
+};
+
+enum
+{
+  EVENT_CONNECTED,
+  EVENT_DISCONNECTED,
+  EVENT_GOT_IP
+};
+
+static std::list<WiFiEventHandler> handlers;
+static std::string saved, ssid;
+static bool connected = false;
+static int8_t rssi = 0;
+
+// handlers whose handle the caller dropped are removed on the way
+static void fire(int kind, const void *event)
+{
+  for (auto it = handlers.begin(); it != handlers.end();)
+  {
+    if (it->use_count() == 1)
+    {
+      it = handlers.erase(it);
+      continue;
+    }
+    WiFiEventHandler handler = *it++;
+    if (handler->kind == kind)
+      handler->func(event);
+  }
+}
+
+template <typename Event>
+static WiFiEventHandler add(int kind, std::function<void(const Event &)> func)
+{
+  WiFiEventHandler handler = std::make_shared<WiFiEventHandlerOpaque>();
+  handler->kind = kind;
+  handler->func = [func](const void *event) { func(*(const Event *)event); };
+  handlers.push_back(handler);
+  return handler;
+}
+
+wl_status_t ESP8266WiFiClass::status() { return connected ? WL_CONNECTED : (saved.empty() ? WL_IDLE_STATUS : WL_DISCONNECTED); }
+bool ESP8266WiFiClass::isConnected() { return connected; }
+String ESP8266WiFiClass::SSID() { return String(connected ? ssid : saved); }
+int32_t ESP8266WiFiClass::RSSI() { return connected ? rssi : 31; }
+
+bool ESP8266WiFiClass::disconnect(bool wifioff)
+{
+  Host::wifiDisconnect();
+  if (wifioff)
+    saved.clear();
+  return true;
+}
+
+WiFiEventHandler ESP8266WiFiClass::onStationModeConnected(std::function<void(const WiFiEventStationModeConnected &)> func)
+{
+  return add(EVENT_CONNECTED, func);
+}
+
+WiFiEventHandler ESP8266WiFiClass::onStationModeDisconnected(std::function<void(const WiFiEventStationModeDisconnected &)> func)
+{
+  return add(EVENT_DISCONNECTED, func);
+}
+
+WiFiEventHandler ESP8266WiFiClass::onStationModeGotIP(std::function<void(const WiFiEventStationModeGotIP &)> func)
+{
+  return add(EVENT_GOT_IP, func);
+}
+
+namespace Host
+{
+  void setSavedNetwork(const char *name) { saved = name; }
+
+  void wifiConnect(const char *name, int8_t strength)
+  {
+    ssid = saved = name;
+    rssi = strength;
+    WiFiEventStationModeConnected associated = {String(name), {0}, 1};
+    fire(EVENT_CONNECTED, &associated);
+    connected = true;
+    WiFiEventStationModeGotIP address = {0x0A00000A, 0x00FFFFFF, 0x0100000A};
+    fire(EVENT_GOT_IP, &address);
+  }
+
+  void wifiDisconnect()
+  {
+    if (!connected)
+      return;
+    connected = false;
+    WiFiEventStationModeDisconnected lost = {String(ssid.c_str()), {0}, 8};
+    fire(EVENT_DISCONNECTED, &lost);
+  }
+}
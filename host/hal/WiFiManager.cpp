@@ -0,0 +1,81 @@
+#include "WiFiManager.h"
+#include "Host.h"
+#include <map>
+#include <string>
+
+static bool submitted = false;
+static std::string submittedSsid;
+static std::map<std::string, std::string> submittedValues;
+
+WiFiManagerParameter::WiFiManagerParameter(const char *id, const char *label, const char *defaultValue, int length)
+{
+  _id = id;
+  _length = length;
+  _value = new char[length + 1];
+  setValue(defaultValue, length);
+}
+
+WiFiManagerParameter::~WiFiManagerParameter() { delete[] _value; }
+
+void WiFiManagerParameter::setValue(const char *value, int length)
+{
+  memset(_value, 0, _length + 1);
+  if (value != NULL)
+    strncpy(_value, value, min(length, _length));
+}
+
+bool WiFiManager::addParameter(WiFiManagerParameter *p)
+{
+  if (_count >= sizeof(_params) / sizeof(_params[0]))
+    return false;
+  _params[_count++] = p;
+  return true;
+}
+
+bool WiFiManager::autoConnect(const char *apName, const char *apPassword)
+{
+  if (WiFi.status() == WL_CONNECTED)
+    return true;
+  return startConfigPortal(apName, apPassword);
+}
+
+bool WiFiManager::startConfigPortal(const char *apName, const char *apPassword)
+{
+  _portal = true;
+  return false;
+}
+
+// the portal closes once the station is up, or once the page was saved
+bool WiFiManager::process()
+{
+  if (_portal && submitted)
+  {
+    submitted = false;
+    for (uint8_t i = 0; i < _count; i++)
+    {
+      auto value = submittedValues.find(_params[i]->getID());
+      if (value != submittedValues.end())
+        _params[i]->setValue(value->second.c_str(), _params[i]->getValueLength());
+    }
+    if (_onSave)
+      _onSave();
+    Host::wifiConnect(submittedSsid.c_str());
+  }
+  if (_portal && WiFi.status() == WL_CONNECTED)
+    _portal = false;
+  return !_portal && WiFi.status() == WL_CONNECTED;
+}
+
+void WiFiManager::resetSettings() { WiFi.disconnect(true); }
+
+namespace Host
+{
+  void submitPortal(const char *ssid, std::initializer_list<std::pair<const char *, const char *>> values)
+  {
+    submitted = true;
+    submittedSsid = ssid;
+    submittedValues.clear();
+    for (auto &value : values)
+      submittedValues[value.first] = value.second;
+  }
+}
@@ -0,0 +1,47 @@
+#ifndef WiFiManager_h
+#define WiFiManager_h
+
+#include "ESP8266WiFi.h"
+
+class WiFiManagerParameter
+{
+public:
+  WiFiManagerParameter(const char *id, const char *label, const char *defaultValue, int length);
+  ~WiFiManagerParameter();
+  const char *getID() { return _id; }
+  const char *getValue() { return _value; }
+  int getValueLength() { return _length; }
+  void setValue(const char *value, int length);
+
+private:
+  const char *_id;
+  char *_value;
+  int _length;
+};
+
+// Captive portal in non-blocking mode. The host plays the user on the
+// portal page with Host::submitPortal(); process() then stores the
+// parameters, calls the save callback and joins the network.
+class WiFiManager
+{
+public:
+  bool addParameter(WiFiManagerParameter *p);
+  void setSaveConfigCallback(std::function<void()> func) { _onSave = func; }
+  void setConfigPortalBlocking(bool blocking) { _blocking = blocking; }
+  void setConfigPortalTimeout(unsigned long seconds) {}
+  void setConnectTimeout(unsigned long seconds) {}
+  void setDebugOutput(bool debug) {}
+  bool autoConnect(const char *apName, const char *apPassword = NULL);
+  bool startConfigPortal(const char *apName, const char *apPassword = NULL);
+  bool getConfigPortalActive() { return _portal; }
+  bool process();
+  void resetSettings();
+
+private:
+  std::function<void()> _onSave;
+  WiFiManagerParameter *_params[8];
+  uint8_t _count = 0;
+  bool _blocking = true, _portal = false;
+};
+
+#endif
@@ -0,0 +1,56 @@
+#include "Wire.h"
+#include "Host.h"
+#include <map>
+
+TwoWire Wire;
+
+static std::map<uint8_t, std::function<void(const uint8_t *, size_t)>> devices;
+
+void TwoWire::begin(int sda, int scl) {}
+void TwoWire::begin() {}
+
+void TwoWire::beginTransmission(uint8_t address)
+{
+  _address = address;
+  _length = 0;
+  _transmitting = true;
+}
+
+size_t TwoWire::write(uint8_t data)
+{
+  if (!_transmitting || _length >= BUFFER_LENGTH)
+    return 0;
+  _buffer[_length++] = data;
+  return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t quantity)
+{
+  size_t n = 0;
+  while (n < quantity && write(data[n]))
+    n++;
+  return n;
+}
+
+// 0 sent, 2 address not acknowledged
+uint8_t TwoWire::endTransmission(bool stop)
+{
+  _transmitting = false;
+  if (!Host::hasI2C(_address))
+    return 2;
+  Host::transmitI2C(_address, _buffer, _length);
+  return 0;
+}
+
+namespace Host
+{
+  void attachI2C(uint8_t address, std::function<void(const uint8_t *, size_t)> func) { devices[address] = func; }
+  bool hasI2C(uint8_t address) { return devices.count(address) > 0; }
+
+  void transmitI2C(uint8_t address, const uint8_t *data, size_t length)
+  {
+    auto device = devices.find(address);
+    if (device != devices.end() && device->second != NULL)
+      device->second(data, length);
+  }
+}
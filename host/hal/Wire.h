@@ -0,0 +1,34 @@
+#ifndef TwoWire_h
+#define TwoWire_h
+
+#include "Arduino.h"
+
+#define BUFFER_LENGTH 128
+
+// I2C master; a transmission reaches the device attached at its address
+// with Host::attachI2C(), and a missing device does not acknowledge.
+class TwoWire : public Stream
+{
+public:
+  void begin(int sda, int scl);
+  void begin();
+  void setClock(uint32_t frequency) {}
+  void beginTransmission(uint8_t address);
+  uint8_t endTransmission(bool stop = true);
+  uint8_t requestFrom(uint8_t address, uint8_t quantity) { return 0; }
+  size_t write(uint8_t data) override;
+  size_t write(const uint8_t *data, size_t quantity) override;
+  using Print::write;
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+
+private:
+  uint8_t _address = 0, _length = 0;
+  bool _transmitting = false;
+  uint8_t _buffer[BUFFER_LENGTH];
+};
+
+extern TwoWire Wire;
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef Check_h
+#define Check_h
+
+#include <stdio.h>
+
+// The host tests' assertion: a failed CHECK prints where and what, and the
+// test goes on, so one run reports every failure.
+static int failures = 0;
+
+#define CHECK(cond)                                               \
+  do                                                              \
+  {                                                               \
+    if (!(cond))                                                  \
+    {                                                             \
+      fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      failures++;                                                 \
+    }                                                             \
+  } while (0)
+
+// main()'s last word: "<name>: ok" and a zero exit once every CHECK held
+static inline int report(const char *name)
+{
+  if (failures == 0)
+    printf("%s: ok\n", name);
+  return failures == 0 ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,232 @@
+// ButtonEvent on synthetic edge streams: the ISR ring, the event logic it
+// replays into, polling, and the analog ladder's classify() and debounce.
+#include <Arduino.h>
+#include <Host.h>
+#include "ButtonEvent.h"
+#include "Check.h"
+
+#define PIN_A 5
+#define PIN_B 4
+#define PIN_LADDER 0
+
+struct Seen
+{
+  int down, up, hold, twice, stum;
+  ButtonHandle handle;
+  unsigned long holdMillis, doubleMillis;
+};
+
+static Seen seen;
+
+static void onDown(ButtonInformation *sender)
+{
+  seen.down++;
+  seen.handle = sender->handle;
+}
+
+static void onUp(ButtonInformation *sender)
+{
+  seen.up++;
+  seen.holdMillis = sender->holdMillis;
+}
+
+static void onHold(ButtonInformation *sender)
+{
+  seen.hold++;
+  seen.holdMillis = sender->holdMillis;
+}
+
+static void onDouble(ButtonInformation *sender)
+{
+  seen.twice++;
+  seen.doubleMillis = sender->doubleMillis;
+}
+
+static void onStum(ButtonInformation *sender) { seen.stum++; }
+
+static void wait(unsigned long ms) { Host::advance((uint64_t)ms * 1000); }
+
+// an edge at ms from now, through the pin and its interrupt
+static void edge(unsigned long ms, uint8_t pin, uint8_t level) { Host::schedule(Host::getMicros() + ms * 1000, pin, level); }
+
+static void ring()
+{
+  ButtonEdgeRing ring;
+  ButtonEdgeRing::Source source = {&ring, 3, PIN_A};
+  ring.attach(&source);
+
+  edge(1, PIN_A, HIGH);
+  edge(2, PIN_A, LOW);
+  wait(5);
+  ButtonEdge popped;
+  CHECK(ring.pop(&popped) && popped.index == 3 && popped.pressed);
+  unsigned long pressedAt = popped.millis;
+  CHECK(ring.pop(&popped) && !popped.pressed && popped.millis == pressedAt + 1);
+  CHECK(!ring.pop(&popped));
+
+  // a bounce burst longer than the ring: the oldest edges are kept
+  for (int i = 0; i < BUTTON_RING_SIZE + 4; i++)
+    Host::setInput(PIN_A, i % 2 ? LOW : HIGH);
+  CHECK(ring.getOverflows() == 5);
+  int count = 0;
+  while (ring.pop(&popped))
+    CHECK(popped.pressed == (count++ % 2 == 0));
+  CHECK(count == BUTTON_RING_SIZE - 1);
+  ring.detach(&source);
+  Host::setInput(PIN_A, LOW);
+}
+
+static void interruptMode()
+{
+  ButtonEvents<4> buttons;
+  ButtonHandle a = buttons.addButton(PIN_A, onDown, onUp, onHold, 1000, onDouble, 300);
+  ButtonHandle b = buttons.addButton(PIN_B);
+  buttons.setDownEvent(b, onDown);
+  buttons.setUpEvent(b, onUp);
+  buttons.setStumEvent(a, onStum, 3000);
+  buttons.setInterruptMode(true);
+  buttons.loop();
+
+  // a tap shorter than a loop pass: both edges survive, with their times
+  seen = {};
+  edge(10, PIN_B, HIGH);
+  edge(40, PIN_B, LOW);
+  wait(100);
+  buttons.loop();
+  CHECK(seen.down == 1 && seen.up == 1 && seen.handle == b && seen.holdMillis == 30);
+
+  // two taps inside the double window, then a hold
+  seen = {};
+  wait(1000);
+  edge(0, PIN_A, HIGH);
+  edge(50, PIN_A, LOW);
+  edge(200, PIN_A, HIGH);
+  wait(250);
+  buttons.loop();
+  CHECK(seen.twice == 1 && seen.doubleMillis == 200 && seen.up == 1);
+  wait(1000);
+  buttons.loop();
+  CHECK(seen.hold == 1 && seen.holdMillis >= 1000);
+  buttons.loop();
+  CHECK(seen.hold == 1);
+  edge(0, PIN_A, LOW);
+  wait(1);
+  buttons.loop();
+  CHECK(seen.up == 2 && seen.holdMillis >= 1000);
+
+  // released long enough: one stum event, not one per pass
+  wait(3100);
+  buttons.loop();
+  buttons.loop();
+  CHECK(seen.stum == 1);
+  buttons.setInterruptMode(false);
+}
+
+static void overflow()
+{
+  ButtonEvents<4> buttons;
+  ButtonHandle a = buttons.addButton(PIN_A);
+  buttons.setDownEvent(a, onDown);
+  buttons.setUpEvent(a, onUp);
+  buttons.setHoldEvent(a, onHold, 1000);
+  buttons.setInterruptMode(true);
+  buttons.loop();
+
+  // a bounce burst longer than the ring, settling released: the ring keeps
+  // the oldest edges, ending pressed, and the line puts the button back up
+  seen = {};
+  for (int i = 0; i < 20; i++)
+    edge(1, PIN_A, i % 2 ? LOW : HIGH);
+  wait(5);
+  buttons.loop();
+  CHECK(buttons.getOverflows() > 0);
+  CHECK(seen.down > 0 && seen.up == seen.down);
+
+  // and stays up: nothing is left pressed by the dropped edge
+  int downs = seen.down;
+  wait(4000);
+  buttons.loop();
+  CHECK(seen.down == downs && seen.up == downs && seen.hold == 0);
+  buttons.setInterruptMode(false);
+}
+
+static void polling()
+{
+  ButtonEvents<4> buttons;
+  ButtonHandle a = buttons.addButton(PIN_A);
+  buttons.setDownEvent(a, onDown);
+  buttons.setUpEvent(a, onUp);
+
+  // without interrupts an edge pair between passes is invisible
+  seen = {};
+  edge(1, PIN_A, HIGH);
+  edge(2, PIN_A, LOW);
+  wait(5);
+  buttons.loop();
+  CHECK(seen.down == 0 && seen.up == 0);
+  Host::setInput(PIN_A, HIGH);
+  buttons.loop();
+  Host::setInput(PIN_A, LOW);
+  buttons.loop();
+  CHECK(seen.down == 1 && seen.up == 1);
+}
+
+static ButtonHandle settle(ButtonEvents<4> &buttons, short value)
+{
+  Host::setAnalog(PIN_LADDER, value);
+  seen.handle = INVALID_BUTTON;
+  for (int i = 0; i < LADDER_DEBOUNCE + 1; i++)
+  {
+    wait(LADDER_SCAN_MILLIS);
+    buttons.loop();
+  }
+  return seen.handle;
+}
+
+static void ladder()
+{
+  ButtonEvents<4> buttons;
+  ButtonHandle high = buttons.addButton(PIN_LADDER, 600, 20, onDown, onUp, NULL, 0, NULL, 0);
+  ButtonHandle low = buttons.addButton(PIN_LADDER, 100, 20, onDown, onUp, NULL, 0, NULL, 0);
+  ButtonHandle middle = buttons.addButton(PIN_LADDER, 300, 20, onDown, onUp, NULL, 0, NULL, 0);
+
+  // windows are inclusive, gaps and the ends belong to no key
+  seen = {};
+  CHECK(settle(buttons, 80) == low);
+  CHECK(settle(buttons, 0) == INVALID_BUTTON && seen.up == 1);
+  CHECK(settle(buttons, 320) == middle);
+  CHECK(settle(buttons, 321) == INVALID_BUTTON);
+  CHECK(settle(buttons, 599) == high);
+  CHECK(settle(buttons, 1023) == INVALID_BUTTON);
+  CHECK(settle(buttons, 121) == INVALID_BUTTON);
+  CHECK(seen.down == 3 && seen.up == 3);
+
+  // one odd scan between steady ones changes nothing
+  Host::setAnalog(PIN_LADDER, 100);
+  for (int i = 0; i < 4; i++)
+  {
+    wait(LADDER_SCAN_MILLIS);
+    buttons.loop();
+  }
+  int downs = seen.down;
+  Host::setAnalog(PIN_LADDER, 600);
+  wait(LADDER_SCAN_MILLIS);
+  buttons.loop();
+  Host::setAnalog(PIN_LADDER, 100);
+  for (int i = 0; i < 4; i++)
+  {
+    wait(LADDER_SCAN_MILLIS);
+    buttons.loop();
+  }
+  CHECK(seen.down == downs && seen.up == 3);
+}
+
+int main()
+{
+  ring();
+  interruptMode();
+  overflow();
+  polling();
+  ladder();
+  return report("buttons");
+}
@@ -0,0 +1,61 @@
+// ThermostatDHT::decode() on edge captures: micros() of every edge with the
+// line level in bit 0, as the driver's interrupt stores them, taken through
+// that interrupt from the host DHT and rebased to the release edge.
+#include <Arduino.h>
+#include "ThermostatDHT.h"
+#include "Check.h"
+
+// DHT11 answering 41 %, 23.4 C
+static const uint32_t DHT11_FRAME[] = {
+    1, 30, 111, 190, 241, 266, 317, 344, 395, 464,
+    515, 540, 591, 660, 711, 738, 789, 814, 865, 934,
+    985, 1012, 1063, 1088, 1139, 1166, 1217, 1242, 1293, 1320,
+    1371, 1396, 1447, 1474, 1525, 1550, 1601, 1628, 1679, 1704,
+    1755, 1782, 1833, 1902, 1953, 1978, 2029, 2098, 2149, 2218,
+    2269, 2338, 2389, 2416, 2467, 2492, 2543, 2570, 2621, 2646,
+    2697, 2724, 2775, 2844, 2895, 2920, 2971, 2998, 3049, 3074,
+    3125, 3194, 3245, 3272, 3323, 3348, 3399, 3426, 3477, 3546,
+    3597, 3622, 3673, 3700, 3751};
+
+// DHT22 answering 81.2 %, -7.3 C
+static const uint32_t DHT22_FRAME[] = {
+    1, 30, 111, 190, 241, 266, 317, 344, 395, 420,
+    471, 498, 549, 574, 625, 652, 703, 772, 823, 892,
+    943, 968, 1019, 1046, 1097, 1166, 1217, 1242, 1293, 1362,
+    1413, 1482, 1533, 1560, 1611, 1636, 1687, 1756, 1807, 1834,
+    1885, 1910, 1961, 1988, 2039, 2064, 2115, 2142, 2193, 2218,
+    2269, 2296, 2347, 2372, 2423, 2492, 2543, 2570, 2621, 2646,
+    2697, 2766, 2817, 2844, 2895, 2920, 2971, 3040, 3091, 3160,
+    3211, 3280, 3331, 3400, 3451, 3520, 3571, 3640, 3691, 3718,
+    3769, 3794, 3845, 3872, 3923};
+
+#define EDGES(capture) (uint8_t)(sizeof(capture) / sizeof(capture[0]))
+
+int main()
+{
+  float temperature = NAN, humidity = NAN;
+  CHECK(ThermostatDHT::decode(DHT11_FRAME, EDGES(DHT11_FRAME), DHT11, temperature, humidity));
+  CHECK(fabsf(temperature - 23.4f) < 0.01f && fabsf(humidity - 41) < 0.01f);
+
+  // the sign bit of the DHT22 temperature
+  CHECK(ThermostatDHT::decode(DHT22_FRAME, EDGES(DHT22_FRAME), DHT22, temperature, humidity));
+  CHECK(fabsf(temperature + 7.3f) < 0.01f && fabsf(humidity - 81.2f) < 0.01f);
+
+  // one zero read as a one: the checksum no longer adds up, nothing is
+  // written back
+  uint32_t misread[EDGES(DHT11_FRAME)];
+  memcpy(misread, DHT11_FRAME, sizeof(misread));
+  CHECK(misread[45] - misread[44] < DHT_BIT_THRESHOLD);
+  misread[45] += 44;
+  temperature = humidity = NAN;
+  CHECK(!ThermostatDHT::decode(misread, EDGES(misread), DHT11, temperature, humidity));
+  CHECK(isnan(temperature) && isnan(humidity));
+
+  // a capture cut short by the timeout: fewer than 40 bits
+  CHECK(!ThermostatDHT::decode(DHT11_FRAME, 60, DHT11, temperature, humidity));
+  // a late release that missed the preamble still has all 40 bits
+  CHECK(ThermostatDHT::decode(DHT11_FRAME + 4, EDGES(DHT11_FRAME) - 4, DHT11, temperature, humidity));
+  CHECK(!ThermostatDHT::decode(DHT11_FRAME, 0, DHT11, temperature, humidity));
+
+  return report("dht");
+}
@@ -0,0 +1,121 @@
+// ThermostatGroup against single Thermostats: every zone, fed the same
+// random stream as its own Thermostat, must drive the same relays and
+// count the same cycles on every tick, and report only what changed.
+#include <Arduino.h>
+#include "ThermostatGroup.h"
+#include <vector>
+#include "Check.h"
+
+#define ZONES 16
+#define TICKS 200000
+
+int main()
+{
+  ThermostatGroup<ZONES> group;
+  std::vector<BasicThermostat<ThermostatNoHooks>> singles(ZONES);
+  for (uint16_t i = 0; i < ZONES; i++)
+  {
+    CHECK(group.addZone(3 * i, 3 * i + 1, 3 * i + 2) == i);
+    singles[i].setHysteresis(1.0);
+    singles[i].setMinOnTime(60000);
+    singles[i].setMinOffTime(90000);
+    singles[i].setFanOverrun(20000);
+  }
+  CHECK(group.addZone(0, 1, 2) == INVALID_ZONE);
+  group.setHysteresis(1.0);
+  group.setMinOnTime(60000);
+  group.setMinOffTime(90000);
+  group.setFanOverrun(20000);
+  group.begin();
+
+  uint32_t reports = 0, changed = 0;
+  uint8_t seen[ZONES] = {0};
+  group.setOnZoneChange([&](uint16_t zone, uint8_t changes) {
+    reports++;
+    seen[zone] |= changes;
+  });
+
+  ThermostatState states[ZONES];
+  float points[ZONES], temperatures[ZONES];
+  for (uint16_t i = 0; i < ZONES; i++)
+  {
+    states[i] = (ThermostatState)random(4);
+    points[i] = random(18, 26);
+    temperatures[i] = random(150, 300) / 10.0f;
+  }
+  // the first pass reports every zone's starting values
+  for (uint16_t i = 0; i < ZONES; i++)
+  {
+    group.setState(i, states[i]);
+    group.setPoint(i, points[i]);
+    group.setTemperature(i, temperatures[i]);
+  }
+  group.update(0);
+  for (uint16_t i = 0; i < ZONES; i++)
+  {
+    singles[i].runner(states[i], points[i], temperatures[i], 0);
+    CHECK(seen[i] & ZONE_POINT);
+  }
+
+  bool same = true;
+  unsigned long now = 100;
+  for (uint32_t tick = 0; tick < TICKS && same; tick++, now += 100)
+  {
+    memset(seen, 0, sizeof(seen));
+    uint16_t zone = random(ZONES);
+    uint8_t expected = 0;
+    switch (random(40))
+    {
+    case 0:
+      states[zone] = (ThermostatState)random(4);
+      break;
+    case 1:
+      points[zone] = random(18, 26);
+      break;
+    case 2:
+      temperatures[zone] = NAN;
+      break;
+    default:
+      if (!isnan(temperatures[zone]) && random(2))
+        temperatures[zone] += random(-2, 3) / 10.0f;
+      else if (isnan(temperatures[zone]))
+        temperatures[zone] = random(150, 300) / 10.0f;
+      break;
+    }
+    uint32_t before = reports;
+    ThermostatState state = group.getState(zone);
+    float point = group.getPoint(zone), temperature = group.getTemperature(zone);
+    if (states[zone] != state)
+      expected |= ZONE_STATE;
+    if (points[zone] != point && !(isnan(points[zone]) && isnan(point)))
+      expected |= ZONE_POINT;
+    if (temperatures[zone] != temperature && !(isnan(temperatures[zone]) && isnan(temperature)))
+      expected |= ZONE_TEMPERATURE;
+    for (uint16_t i = 0; i < ZONES; i++)
+    {
+      group.setState(i, states[i]);
+      group.setPoint(i, points[i]);
+      group.setTemperature(i, temperatures[i]);
+    }
+    group.update(now);
+    for (uint16_t i = 0; i < ZONES; i++)
+    {
+      singles[i].runner(states[i], points[i], temperatures[i], now);
+      same &= group.getOutputs(i) == singles[i].getRelays()->getOutputs();
+      same &= group.getCycles(i) == singles[i].getCycles();
+      if (i != zone)
+        same &= (seen[i] & ~ZONE_OUTPUTS) == 0;
+    }
+    same &= (seen[zone] & ~ZONE_OUTPUTS) == expected;
+    changed += reports - before;
+  }
+  CHECK(same);
+  CHECK(changed > 0);
+
+  uint32_t cycles = 0;
+  for (uint16_t i = 0; i < ZONES; i++)
+    cycles += group.getCycles(i);
+  CHECK(cycles > 0);
+
+  return report("group");
+}
@@ -0,0 +1,108 @@
+// ThermostatJournal across simulated reboots: each begin() on a fresh
+// instance scans the flash the previous one left, including torn writes.
+#include <Arduino.h>
+#include "ThermostatJournal.h"
+#include "Check.h"
+
+extern "C" uint32_t _FS_start;
+
+struct Record
+{
+  uint32_t value;
+  char text[20];
+};
+
+// slot layout of the journal: 12 byte header, payload, padded to 4
+#define SLOT ((12 + sizeof(Record) + 3) & ~3)
+#define SLOTS (SPI_FLASH_SEC_SIZE / SLOT)
+
+static uint32_t base() { return (uint32_t)((uintptr_t)&_FS_start - 0x40200000); }
+static uint32_t slot(uint8_t sector, uint16_t index) { return base() + sector * SPI_FLASH_SEC_SIZE + index * SLOT; }
+
+static void wipe()
+{
+  for (uint8_t sector = 0; sector < JOURNAL_SECTORS; sector++)
+    ESP.flashEraseSector(base() / SPI_FLASH_SEC_SIZE + sector);
+}
+
+static void commit(uint32_t value)
+{
+  ThermostatJournal journal(sizeof(Record), JOURNAL_SECTORS, 0);
+  journal.begin();
+  Record record = {value, "record"};
+  journal.write(&record);
+  CHECK(journal.flush());
+}
+
+static bool restore(uint32_t &value)
+{
+  ThermostatJournal journal(sizeof(Record), JOURNAL_SECTORS, 0);
+  Record record;
+  if (!journal.begin() || !journal.read(&record))
+    return false;
+  value = record.value;
+  return true;
+}
+
+// a write cut short: the header landed with its sequence still erased,
+// the payload and its CRC did not
+static void tear(uint32_t address)
+{
+  uint32_t header[3] = {JOURNAL_MAGIC, 0xFFFFFFFF, 0xFFFF0000 | sizeof(Record)};
+  ESP.flashWrite(address, header, sizeof(header));
+}
+
+int main()
+{
+  uint32_t value = 0;
+
+  wipe();
+  CHECK(!restore(value));
+  commit(1);
+  commit(2);
+  CHECK(restore(value) && value == 2);
+
+  // torn header after the newest record: the erased sequence must not win
+  tear(slot(0, 2));
+  CHECK(restore(value) && value == 2);
+  commit(3);
+  CHECK(restore(value) && value == 3);
+  commit(4);
+  CHECK(restore(value) && value == 4);
+
+  // a full sector, then a write torn at the start of the next one: the
+  // newest record is the last of the previous sector
+  wipe();
+  for (uint32_t i = 1; i <= SLOTS; i++)
+    commit(i);
+  ESP.flashEraseSector(base() / SPI_FLASH_SEC_SIZE + 1);
+  tear(slot(1, 0));
+  CHECK(restore(value) && value == SLOTS);
+  commit(SLOTS + 1);
+  CHECK(restore(value) && value == SLOTS + 1);
+
+  // a payload that fails its CRC is skipped the same way
+  commit(SLOTS + 2);
+  uint32_t zero = 0;
+  ESP.flashWrite(slot(1, 1) + 12, &zero, sizeof(zero));
+  CHECK(restore(value) && value == SLOTS + 1);
+
+  // the first record copied into the next slot with its sequence flipped
+  // high: its payload CRC still matches, but the header is covered too
+  wipe();
+  commit(1);
+  commit(2);
+  uint32_t copy[SLOT / 4];
+  ESP.flashRead(slot(0, 0), copy, SLOT);
+  copy[1] = 0x7FFFFFFF;
+  ESP.flashWrite(slot(0, 2), copy, SLOT);
+  CHECK(restore(value) && value == 2);
+
+  // the rotation wraps around all sectors and keeps the newest
+  wipe();
+  for (uint32_t i = 1; i <= SLOTS * JOURNAL_SECTORS + 3; i++)
+    commit(i);
+  CHECK(restore(value) && value == SLOTS * JOURNAL_SECTORS + 3);
+
+  return report("journal");
+}
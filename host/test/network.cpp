@@ -0,0 +1,71 @@
+// ThermostatNetwork backoff: asking for the delay is free, only counted
+// failures lengthen it, and the station or the cloud coming up resets it.
+// The station's down time runs from begin() or its last drop, not from
+// boot, and a forgotten network is no longer reported as saved.
+#include <Arduino.h>
+#include <Host.h>
+#include "ThermostatNetwork.h"
+#include "Check.h"
+
+// every draw of the jittered delay falls in [step / 2, step]
+static bool within(ThermostatNetwork &network, unsigned long step)
+{
+  for (int i = 0; i < 100; i++)
+  {
+    unsigned long backoff = network.getBackoff();
+    if (backoff < step / 2 || backoff > step)
+      return false;
+  }
+  return true;
+}
+
+int main()
+{
+  ThermostatNetwork network;
+  network.begin();
+  CHECK(within(network, NETWORK_BACKOFF_MIN));
+  CHECK(network.getAttempts() == 0);
+
+  network.countFailure();
+  network.countFailure();
+  CHECK(within(network, NETWORK_BACKOFF_MIN * 4));
+
+  // a fresh station starts over, and the first delay is the first step
+  Host::wifiConnect("home");
+  network.loop();
+  CHECK(network.getAttempts() == 0);
+  CHECK(within(network, NETWORK_BACKOFF_MIN));
+
+  for (int i = 0; i < 30; i++)
+    network.countFailure();
+  CHECK(within(network, NETWORK_BACKOFF_MAX));
+
+  network.setCloudConnected(true);
+  CHECK(within(network, NETWORK_BACKOFF_MIN));
+  network.setCloudConnected(false);
+  CHECK(network.getCloudDrops() == 1);
+  CHECK(within(network, NETWORK_BACKOFF_MIN));
+
+  // booted long ago: the attempt is as old as begin(), not as millis()
+  Host::wifiDisconnect();
+  Host::advance(60000000);
+  ThermostatNetwork later;
+  later.begin();
+  CHECK(later.hasSavedNetwork());
+  CHECK(later.getDownTime() == 0);
+  Host::advance(5000000);
+  CHECK(later.getDownTime() == 5000);
+  Host::wifiConnect("home");
+  CHECK(later.getDownTime() == 0);
+  Host::advance(1000000);
+  Host::wifiDisconnect();
+  Host::advance(2000000);
+  CHECK(later.getDownTime() == 2000);
+
+  // the portal's reset erases the saved network, and the cache with it
+  WiFi.disconnect(true);
+  later.forget();
+  CHECK(!later.hasSavedNetwork());
+
+  return report("network");
+}
@@ -0,0 +1,76 @@
+// ThermostatOutbox pacing: kinds take turns for the tokens, a waiting
+// message is counted as throttled once, and refills keep the part of an
+// interval already earned.
+#include <Arduino.h>
+#include <Host.h>
+#include "ThermostatOutbox.h"
+#include "Check.h"
+
+static uint32_t sent[ThermostatOutbox::KINDS];
+
+static void wait(unsigned long ms) { Host::advance((uint64_t)ms * 1000); }
+
+int main()
+{
+  ThermostatOutbox outbox(1000, 1);
+  outbox.setSender([](ThermostatOutbox::Kind kind) {
+    sent[kind]++;
+    return true;
+  });
+  outbox.setConnected(true);
+  outbox.loop();
+
+  // MODE posted every pass, SETTING now and then: SETTING still gets turns
+  for (int ms = 0; ms < 20000; ms++)
+  {
+    outbox.post(ThermostatOutbox::MODE);
+    if (ms % 4000 == 0)
+      outbox.post(ThermostatOutbox::SETTING);
+    outbox.loop();
+    wait(1);
+  }
+  CHECK(sent[ThermostatOutbox::SETTING] == 5);
+  CHECK(sent[ThermostatOutbox::MODE] >= 14);
+
+  // one message held over thousands of passes is throttled once
+  ThermostatOutbox held(1000, 1);
+  held.setSender([](ThermostatOutbox::Kind kind) { return true; });
+  held.setConnected(true);
+  held.post(ThermostatOutbox::MODE);
+  held.loop();
+  held.post(ThermostatOutbox::SETTING);
+  for (int ms = 0; ms < 900; ms++)
+  {
+    held.loop();
+    wait(1);
+  }
+  CHECK(held.getThrottled() == 1);
+  CHECK(held.getSent() == 1);
+
+  // a send every 1.5 intervals: the halves left over add up, so by 7.5 s
+  // there is a token to spare for a second message in the same pass
+  ThermostatOutbox paced(1000, 3);
+  uint32_t count = 0;
+  paced.setSender([&](ThermostatOutbox::Kind kind) {
+    count++;
+    return true;
+  });
+  paced.setConnected(true);
+  for (int i = 0; i < 3; i++)
+  {
+    paced.post(ThermostatOutbox::MODE);
+    paced.loop();
+  }
+  for (int i = 0; i < 5; i++)
+  {
+    wait(1500);
+    paced.post(ThermostatOutbox::MODE);
+    paced.loop();
+  }
+  CHECK(count == 3 + 5);
+  paced.post(ThermostatOutbox::MODE);
+  paced.loop();
+  CHECK(count == 3 + 6);
+
+  return report("outbox");
+}
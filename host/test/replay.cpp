@@ -0,0 +1,145 @@
+// Records a scripted session of Thermostat.ino built with TRACE on, then
+// plays the trace back into a fresh sketch and checks the relays, the
+// panel, the cloud frames and the trace it writes again come out the same.
+// The recording runs in a child process, so the replay boots clean.
+#include <Arduino.h>
+#include <Host.h>
+#include <IRrecv.h>
+#include "Replay.h"
+#include "Check.h"
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define PIN_BTN D3
+#define SESSION 1200000 // ms
+
+void setup();
+void loop();
+
+static void command(const char *action, const char *value)
+{
+  char frame[256];
+  snprintf(frame, sizeof(frame), "{\"deviceId\":\"dev1\",\"action\":\"%s\",\"value\":%s}", action, value);
+  Host::cloudSend(frame);
+}
+
+// every input the trace covers: the portal, Sinric commands, a room
+// drifting through the setpoint, a failing DHT, the remote, the flash
+// button, the station and the socket dropping
+static void step(uint32_t ms)
+{
+  if (ms == 1000)
+    Host::submitPortal("home", {{"sinric_apiKey", "key"}, {"sinric_devId", "dev1"}});
+  if (ms == 5000)
+    command("action.devices.commands.ThermostatSetMode", "{\"thermostatMode\":\"heat\"}");
+  if (ms % 180000 == 90000)
+  {
+    char point[64];
+    snprintf(point, sizeof(point), "{\"thermostatTemperatureSetpoint\":%u}", 20 + ms / 180000 % 5);
+    command("action.devices.commands.ThermostatTemperatureSetpoint", point);
+  }
+  if (ms % 10000 == 0)
+  {
+    uint32_t phase = ms % 600000;
+    float t = phase < 300000 ? 16 + phase / 25000.0f : 28 - (phase - 300000) / 25000.0f;
+    Host::setDHT(t, 45);
+  }
+  if (ms == 400000)
+    Host::setDHT(NAN, NAN);
+  if (ms % 120000 == 60000)
+  {
+    decode_results results = {};
+    results.decode_type = MIRAGE;
+    results.bits = 120;
+    results.state[1] = 1;
+    results.state[4] = (ms / 120000 % 4) << 4 | 1;
+    results.state[5] = 0x6C + ms / 120000 % 17;
+    Host::sendIR(results);
+  }
+  if (ms % 250000 == 30000)
+  {
+    Host::schedule(Host::getMicros() + 200, PIN_BTN, LOW);
+    Host::schedule(Host::getMicros() + 80000, PIN_BTN, HIGH);
+  }
+  if (ms == 500000)
+    Host::wifiDisconnect();
+  if (ms == 560000)
+    Host::wifiConnect("home", -70);
+  if (ms == 800000)
+  {
+    Host::cloudAccept(false);
+    Host::cloudClose();
+  }
+  if (ms == 900000)
+    Host::cloudAccept(true);
+}
+
+static void put(int fd, const std::string &text)
+{
+  uint32_t length = text.size();
+  write(fd, &length, sizeof(length));
+  write(fd, text.data(), length);
+}
+
+static std::string get(FILE *in)
+{
+  uint32_t length = 0;
+  if (fread(&length, sizeof(length), 1, in) != 1)
+    return "";
+  std::string text(length, 0);
+  return fread(&text[0], 1, length, in) == length ? text : "";
+}
+
+int main()
+{
+  int fds[2];
+  pipe(fds);
+  if (fork() == 0)
+  {
+    close(fds[0]);
+    std::string trace;
+    Host::setSerialOutput([&](const uint8_t *data, size_t length) { trace.append((const char *)data, length); });
+    Replay::attachHardware();
+    Host::setDHT(16, 45);
+    Replay::Log log;
+    log.attach();
+    setup();
+    for (uint32_t ms = 0; ms < SESSION; ms++)
+    {
+      step(ms);
+      loop();
+      log.sample();
+      Host::advance(1000);
+    }
+    put(fds[1], trace);
+    put(fds[1], log.relays);
+    put(fds[1], log.panel);
+    put(fds[1], log.cloud);
+    _exit(0);
+  }
+  close(fds[1]);
+  FILE *in = fdopen(fds[0], "r");
+  std::string trace = get(in), relays = get(in), panel = get(in), cloud = get(in);
+  fclose(in);
+  int status;
+  wait(&status);
+  CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  CHECK(trace.size() > 4);
+
+  std::string again;
+  Host::setSerialOutput([&](const uint8_t *data, size_t length) { again.append((const char *)data, length); });
+  Replay::attachHardware();
+  Replay::Log log;
+  CHECK(Replay::run((const uint8_t *)trace.data(), trace.size(), SESSION - 1, &log));
+  CHECK(relays.find(" on\n") != std::string::npos);
+  CHECK(cloud.size() > 0);
+  CHECK(log.relays == relays);
+  CHECK(log.panel == panel);
+  CHECK(log.cloud == cloud);
+  CHECK(again == trace);
+
+  // a damaged trace is refused before the sketch boots
+  CHECK(!Replay::run((const uint8_t *)"TRC0", 4, 0, NULL));
+
+  return report("replay");
+}
@@ -0,0 +1,33 @@
+// ThermostatSimulation past the 49 days of a 32-bit millisecond clock:
+// the run times and the comfort error keep adding up.
+#include <Arduino.h>
+#include "ThermostatSimulation.h"
+#include "Check.h"
+
+#define DAY 86400000ULL
+
+int main()
+{
+  ThermostatSimulation simulation(20);
+  simulation.setOutdoor(10);
+  simulation.setGains(10, 10);
+
+  // heating with the fan on for 60 days, in one minute steps: the room
+  // settles at the outdoor temperature plus the gain, 20 C
+  for (uint64_t now = 0; now <= 60 * DAY; now += 60000)
+    simulation.step(RELAY_HEAT | RELAY_FAN, HEAT, 21, now);
+  CHECK(simulation.getElapsed() == 60 * DAY);
+  CHECK(simulation.getCompressorMillis() == 60 * DAY);
+  CHECK(simulation.getFanMillis() == 60 * DAY);
+  CHECK(fabsf(simulation.getTemperature() - 20) < 0.01);
+  CHECK(fabsf(simulation.getComfortError() - 1) < 0.01);
+  CHECK(fabsf(simulation.getEnergy() - 60 * 24 * (SIMULATION_COMPRESSOR + SIMULATION_FAN)) < 1);
+
+  // one step across the old wrap is integrated whole
+  ThermostatSimulation jump(20);
+  jump.step(0, OFF, NAN, 0);
+  jump.step(RELAY_FAN, FAN, NAN, 50 * DAY);
+  CHECK(jump.getFanMillis() == 50 * DAY && jump.getCompressorMillis() == 0);
+
+  return report("simulation");
+}
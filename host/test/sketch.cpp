@@ -0,0 +1,68 @@
+// Boots Thermostat.ino on the fake core and walks it through the portal,
+// the cloud and a heating cycle, checking what the outside world sees:
+// the relay lines, the panel, the DHT line and the socket.
+#include <Arduino.h>
+#include <Host.h>
+#include "Check.h"
+
+#define PIN_FAN D0
+#define PIN_COOL D5
+#define PIN_HEAT D6
+#define PIN_DHT D9
+
+void setup();
+void loop();
+
+static void run(unsigned long ms)
+{
+  for (unsigned long i = 0; i < ms; i++)
+  {
+    loop();
+    Host::advance(1000);
+  }
+}
+
+static bool on(uint8_t pin) { return Host::getOutput(pin) == LOW; }
+
+int main()
+{
+  uint32_t frames = 0, whole = 0;
+  Host::setOnCloudText([&](const char *text, size_t length) {
+    frames++;
+    whole += length > 0 && text[0] == '{' && text[length - 1] == '}' && strlen(text) == length;
+  });
+  Host::attachDHT(PIN_DHT, 11);
+  Host::setDHT(18, 40);
+  Host::attachPanel(0x3C);
+
+  setup();
+  run(1000);
+  CHECK(!on(PIN_FAN) && !on(PIN_COOL) && !on(PIN_HEAT));
+  CHECK(Host::getDHTFrames() > 0);
+  CHECK(Host::getPanelBytes() > 0);
+  CHECK(!Host::isCloudOpen());
+
+  Host::submitPortal("home", {{"sinric_apiKey", "key"}, {"sinric_devId", "dev1"}});
+  run(1000);
+  CHECK(Host::isCloudOpen());
+
+  Host::cloudSend("{\"deviceId\":\"dev1\",\"action\":\"action.devices.commands.ThermostatSetMode\",\"value\":{\"thermostatMode\":\"heat\"}}");
+  Host::cloudSend("{\"deviceId\":\"dev1\",\"action\":\"action.devices.commands.ThermostatTemperatureSetpoint\",\"value\":{\"thermostatTemperatureSetpoint\":25}}");
+  Host::cloudSend("{\"deviceId\":\"other\",\"action\":\"action.devices.commands.ThermostatSetMode\",\"value\":{\"thermostatMode\":\"cool\"}}");
+  run(200000);
+  CHECK(on(PIN_HEAT) && !on(PIN_COOL));
+  CHECK(frames > 0);
+  CHECK(whole == frames);
+
+  Host::setDHT(27, 40);
+  run(400000);
+  CHECK(!on(PIN_HEAT) && !on(PIN_COOL));
+
+  Host::cloudClose();
+  run(10);
+  CHECK(!Host::isCloudOpen());
+  run(120000);
+  CHECK(Host::isCloudOpen());
+
+  return report("sketch");
+}
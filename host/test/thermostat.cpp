@@ -0,0 +1,75 @@
+// Thermostat control against its change notification: the deadband holds
+// back the hooks, never the reading the cycle state machine runs on.
+#include <Arduino.h>
+#include "Thermostat.h"
+#include "Check.h"
+
+static int reported = 0, pointReported = 0;
+static float last = NAN;
+
+struct Hooks : ThermostatNoHooks
+{
+  float onTemperatureChange(float oldTemperature, float temperature)
+  {
+    reported++;
+    last = temperature;
+    return temperature;
+  }
+
+  float onPointChange(float oldPoint, float point)
+  {
+    pointReported++;
+    return point;
+  }
+};
+
+int main()
+{
+  BasicThermostat<Hooks> thermostat;
+  thermostat.begin();
+  thermostat.setHysteresis(1.0);
+  thermostat.setTemperatureDeadband(0.5);
+
+  // no reading yet: nothing to report, however often it is repeated
+  thermostat.runner(ThermostatState::HEAT, 20, NAN, 0);
+  thermostat.runner(ThermostatState::HEAT, 20, NAN, 100);
+  CHECK(reported == 0);
+
+  thermostat.runner(ThermostatState::HEAT, 20, 19.7, 200);
+  CHECK(reported == 1 && last == 19.7f);
+  CHECK(!(thermostat.getRelays()->getOutputs() & RELAY_HEAT));
+
+  // 0.3 below the last report: not reported, but below the band edge
+  thermostat.runner(ThermostatState::HEAT, 20, 19.4, 300);
+  CHECK(reported == 1);
+  CHECK(thermostat.getRelays()->getOutputs() & RELAY_HEAT);
+
+  // slow drift is reported once it adds up to the deadband
+  thermostat.runner(ThermostatState::HEAT, 20, 19.3, 400);
+  CHECK(reported == 1);
+  thermostat.runner(ThermostatState::HEAT, 20, 19.1, 500);
+  CHECK(reported == 2 && last == 19.1f);
+
+  thermostat.runner(ThermostatState::HEAT, 20, NAN, 600);
+  // losing the sensor is a change, and ends the cycle
+  CHECK(reported == 3 && isnan(last));
+  CHECK(!(thermostat.getRelays()->getOutputs() & RELAY_HEAT));
+
+  // a setpoint nudged inside its deadband is not reported but is the one
+  // control runs on: 22.0 -> 22.4 with the room at 22.2 starts heating
+  pointReported = 0;
+  BasicThermostat<Hooks> nudged;
+  nudged.begin();
+  nudged.setHysteresis(0.2);
+  nudged.setPointDeadband(0.5);
+  nudged.runner(ThermostatState::HEAT, 22.0, 22.2, 0);
+  CHECK(pointReported == 1);
+  CHECK(!(nudged.getRelays()->getOutputs() & RELAY_HEAT));
+  nudged.runner(ThermostatState::HEAT, 22.4, 22.2, 100);
+  CHECK(pointReported == 1);
+  CHECK(nudged.getRelays()->getOutputs() & RELAY_HEAT);
+  nudged.runner(ThermostatState::HEAT, 22.6, 22.2, 200);
+  CHECK(pointReported == 2);
+
+  return report("thermostat");
+}